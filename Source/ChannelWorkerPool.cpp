@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    ChannelWorkerPool.cpp
+    A few persistent threads that share out independent channels or
+    tracks during offline rendering.
+
+  ==============================================================================
+*/
+
+#include "ChannelWorkerPool.h"
+
+//==============================================================================
+class ChannelWorkerPool::Worker  : public Thread
+{
+public:
+    Worker (ChannelWorkerPool& p, int slot)
+        : Thread ("EZ Chorus channel worker"), pool (p), workerSlot (slot)
+    {
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            if (batchReady.wait (100) && ! threadShouldExit())
+            {
+                pool.runShare (workerSlot);
+                shareFinished.signal();
+            }
+        }
+    }
+
+    WaitableEvent batchReady;
+    WaitableEvent shareFinished;
+
+private:
+    ChannelWorkerPool& pool;
+    const int workerSlot;
+};
+
+//==============================================================================
+ChannelWorkerPool::ChannelWorkerPool (int numWorkers)
+{
+    for (int i = 0; i < jlimit (1, maxWorkers, numWorkers); i++)
+        workers.add (new Worker (*this, i + 1))->startThread();
+}
+
+ChannelWorkerPool::~ChannelWorkerPool()
+{
+    for (auto* worker : workers)
+    {
+        worker->signalThreadShouldExit();
+        worker->batchReady.signal();
+    }
+
+    for (auto* worker : workers)
+        worker->stopThread (-1);
+}
+
+void ChannelWorkerPool::run (Task& task, int numTasks, Schedule schedule)
+{
+    if (numTasks <= 0)
+        return;
+
+    currentTask = &task;
+    currentNumTasks = numTasks;
+    currentSchedule = schedule;
+    nextTask.store (0);
+
+    for (auto* worker : workers)
+        worker->batchReady.signal();
+
+    runShare (0);
+
+    for (auto* worker : workers)
+        worker->shareFinished.wait (-1);
+}
+
+void ChannelWorkerPool::runShare (int workerSlot)
+{
+    if (currentSchedule == Schedule::dynamic)
+    {
+        for (int index = nextTask.fetch_add (1); index < currentNumTasks; index = nextTask.fetch_add (1))
+            currentTask->runTask (index, workerSlot);
+
+        return;
+    }
+
+    for (int index = workerSlot; index < currentNumTasks; index += workers.size() + 1)
+        currentTask->runTask (index, workerSlot);
+}
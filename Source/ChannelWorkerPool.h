@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    ChannelWorkerPool.h
+    A few persistent threads that share out independent channels during
+    offline rendering of large channel beds.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace juce;
+
+//==============================================================================
+/**
+    Runs a batch of independent tasks across a fixed set of worker threads and
+    the calling thread, returning once all of them are done. Tasks are either
+    dealt out round-robin, which suits channels that all cost the same, or
+    claimed one at a time by whichever thread is free, which balances tasks
+    of uneven cost such as tracks with different settings.
+
+    Workers block on events between batches, so the pool must only be used
+    when the host is rendering offline; the realtime path always processes
+    channels on the audio thread.
+*/
+class ChannelWorkerPool
+{
+public:
+    static constexpr int maxWorkers = 64;
+
+    enum class Schedule
+    {
+        roundRobin,
+        dynamic
+    };
+
+    struct Task
+    {
+        virtual ~Task() = default;
+
+        /** Called once for each index in the batch. workerSlot identifies the
+            thread (0 is the caller) so tasks can pick per-thread scratch space.
+        */
+        virtual void runTask (int index, int workerSlot) = 0;
+    };
+
+    explicit ChannelWorkerPool (int numWorkers);
+    ~ChannelWorkerPool();
+
+    int getNumWorkers() const   { return workers.size(); }
+
+    void run (Task& task, int numTasks, Schedule schedule = Schedule::roundRobin);
+
+private:
+    class Worker;
+
+    void runShare (int workerSlot);
+
+    OwnedArray<Worker> workers;
+
+    Task* currentTask = nullptr;
+    int currentNumTasks = 0;
+    Schedule currentSchedule = Schedule::roundRobin;
+    std::atomic<int> nextTask { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChannelWorkerPool)
+};
@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    ChorusBank.cpp
+    Many independent chorus instances processed together.
+
+  ==============================================================================
+*/
+
+#include "ChorusBank.h"
+
+//==============================================================================
+template <typename SampleType>
+ChorusBank<SampleType>::ChorusBank (int count)
+    : numInstances (jmax (1, count)),
+      instances (new ChorusProcessor<SampleType>[(size_t) numInstances])
+{
+}
+
+template <typename SampleType>
+ChorusBank<SampleType>::~ChorusBank()
+{
+    // The workers must be gone before the instances they might touch.
+    pool.reset();
+}
+
+template <typename SampleType>
+void ChorusBank<SampleType>::prepare (const dsp::ProcessSpec& spec, int numThreads, DelayStorage storage)
+{
+    for (int i = 0; i < numInstances; i++)
+    {
+        instances[i].setDelayStorage (storage);
+        instances[i].prepare (spec);
+    }
+
+    const auto numWorkers = jlimit (0, ChannelWorkerPool::maxWorkers, jmin (numThreads, numInstances) - 1);
+
+    if (numWorkers == 0)
+        pool.reset();
+    else if (pool == nullptr || pool->getNumWorkers() != numWorkers)
+        pool = std::make_unique<ChannelWorkerPool> (numWorkers);
+}
+
+template <typename SampleType>
+void ChorusBank<SampleType>::reset()
+{
+    for (int i = 0; i < numInstances; i++)
+        instances[i].reset();
+}
+
+template <typename SampleType>
+void ChorusBank<SampleType>::prepareForOversampling()
+{
+    for (int i = 0; i < numInstances; i++)
+    {
+        instances[i].collectGarbage();
+        instances[i].prepareForOversampling();
+    }
+}
+
+template <typename SampleType>
+void ChorusBank<SampleType>::setSettings (int instance, const ChorusSettings& settings)
+{
+    jassert (isPositiveAndBelow (instance, numInstances));
+    instances[instance].setSettings (settings);
+}
+
+template <typename SampleType>
+const ChorusSettings& ChorusBank<SampleType>::getSettings (int instance) const
+{
+    jassert (isPositiveAndBelow (instance, numInstances));
+    return instances[instance].getSettings();
+}
+
+template <typename SampleType>
+ChorusProcessor<SampleType>& ChorusBank<SampleType>::getInstance (int instance)
+{
+    jassert (isPositiveAndBelow (instance, numInstances));
+    return instances[instance];
+}
+
+template <typename SampleType>
+int ChorusBank<SampleType>::getLatencySamples (int instance) const
+{
+    jassert (isPositiveAndBelow (instance, numInstances));
+    return instances[instance].getLatencySamples();
+}
+
+template <typename SampleType>
+void ChorusBank<SampleType>::process (const dsp::AudioBlock<SampleType>* blocks)
+{
+    currentBlocks = blocks;
+
+    if (pool != nullptr)
+        pool->run (*this, numInstances, ChannelWorkerPool::Schedule::dynamic);
+    else
+        for (int i = 0; i < numInstances; i++)
+            runTask (i, 0);
+
+    currentBlocks = nullptr;
+}
+
+template <typename SampleType>
+void ChorusBank<SampleType>::runTask (int instance, int)
+{
+    ScopedNoDenormals noDenormals;
+    instances[instance].processInPlace (currentBlocks[instance]);
+}
+
+//==============================================================================
+template class ChorusBank<float>;
+template class ChorusBank<double>;
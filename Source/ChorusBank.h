@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    ChorusBank.h
+    Many independent chorus instances processed together.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChorusProcessor.h"
+
+using namespace juce;
+
+//==============================================================================
+/**
+    A fixed number of independent ChorusProcessor instances, such as one per
+    track of a multitrack render, without an AudioProcessor or parameter tree
+    for each.
+
+    The instances sit side by side in one array, and process() runs all of
+    them in one call. With more than one thread, instances are handed out
+    one at a time to whichever thread is free, so tracks of very different
+    cost (oversampling, voice count, idle tracks) still balance. Each
+    instance runs exactly the code EZChorusAudioProcessor runs, so given the
+    same settings its output matches a plugin instance sample for sample.
+
+    The thread pool blocks between batches, so a bank with worker threads is
+    for offline rendering. Every instance is processed on the calling thread
+    when numThreads is 1.
+
+    The instances don't share one interleaved state, and their samples
+    aren't vectorised across instances. Tracks can differ in kernel rate,
+    voice count and interpolation quality, so lanes across instances would
+    rarely run the same code. Summing them in a different order would also
+    break the sample-for-sample match. Within each instance the voices are
+    vectorised instead (see ChorusState::readVoiceLanes()).
+*/
+template <typename SampleType>
+class ChorusBank  : private ChannelWorkerPool::Task
+{
+public:
+    explicit ChorusBank (int numInstances);
+    ~ChorusBank() override;
+
+    int getNumInstances() const         { return numInstances; }
+
+    /** Message thread: prepares every instance for spec and the oversampling
+        factor in its current settings. numThreads includes the calling
+        thread. Half-float delay storage lets more instances' delay lines
+        stay in cache.
+    */
+    void prepare (const dsp::ProcessSpec& spec, int numThreads = 1,
+                  DelayStorage storage = DelayStorage::full);
+
+    /** Clears every instance's delay lines and filters. */
+    void reset();
+
+    /** Message thread, between process() calls: builds a bigger state for
+        every instance that process() found set to a higher oversampling
+        factor than it was prepared for, and frees the states instances have
+        swapped out. Until then such an instance runs at its prepared factor,
+        exactly as a plugin instance does until its timer has done the same.
+        Offline renders can call it after every block.
+    */
+    void prepareForOversampling();
+
+    void setSettings (int instance, const ChorusSettings& settings);
+    const ChorusSettings& getSettings (int instance) const;
+
+    /** Direct access to one instance, for metering or telemetry. */
+    ChorusProcessor<SampleType>& getInstance (int instance);
+
+    /** Processes blocks[i] in place with instance i, for every instance. The
+        blocks may have different channel counts but no more than were
+        prepared, and no more samples than the prepared maximum block size.
+    */
+    void process (const dsp::AudioBlock<SampleType>* blocks);
+
+    /** The delay in samples that instance's oversampling factor adds. */
+    int getLatencySamples (int instance) const;
+
+private:
+    void runTask (int instance, int workerSlot) override;
+
+    const int numInstances;
+    std::unique_ptr<ChorusProcessor<SampleType>[]> instances;
+    std::unique_ptr<ChannelWorkerPool> pool;
+
+    const dsp::AudioBlock<SampleType>* currentBlocks = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChorusBank)
+};
@@ -0,0 +1,152 @@
+/*
+  ==============================================================================
+
+    ChorusBypass.cpp
+    Click-free bypass for a ChorusProcessor that lets its tail ring out and
+    then stops calling it.
+
+  ==============================================================================
+*/
+
+#include "ChorusBypass.h"
+
+//==============================================================================
+template <typename SampleType>
+void ChorusBypass<SampleType>::prepare (const dsp::ProcessSpec& spec, bool startBypassed)
+{
+    numChannels = jmin ((int) spec.numChannels, ChorusStateBase::maxChannels);
+    maxChunkSize = jmin ((int) spec.maximumBlockSize, ParameterRamp::maxLength);
+    maxLatency = jmax (ChorusStateBase::getOversamplingLatency (2),
+                       ChorusStateBase::getOversamplingLatency (ChorusStateBase::maxOversamplingFactor));
+
+    dryBuffer.allocate ((size_t) (numChannels * maxChunkSize), true);
+    for (int ch = 0; ch < numChannels; ++ch)
+        dryChannels[ch] = dryBuffer + ch * maxChunkSize;
+
+    dryHistory.allocate ((size_t) jmax (1, numChannels * maxLatency), true);
+    latency = 0;
+    historyPos = 0;
+
+    inputGain = startBypassed ? 0.0f : 1.0f;
+    inputFade.prepare (spec.sampleRate, inputGain);
+}
+
+template <typename SampleType>
+bool ChorusBypass<SampleType>::process (const dsp::AudioBlock<SampleType>& block, ChorusProcessor<SampleType>& chorus,
+                                        bool shouldBypass, int latencySamples) noexcept
+{
+    const auto target = shouldBypass ? 0.0f : 1.0f;
+
+    // A new latency starts the dry delay again from silence. It only
+    // changes with the oversampling factor, which clears the chorus anyway.
+    if (const auto newLatency = jlimit (0, maxLatency, latencySamples); newLatency != latency)
+    {
+        latency = newLatency;
+        historyPos = 0;
+        dryHistory.clear ((size_t) (numChannels * maxLatency));
+    }
+
+    // Fully on: the chorus takes the block as it is, and the dry delay only
+    // keeps up so a bypass can start at any time.
+    if (inputGain == 1.0f && target == 1.0f)
+    {
+        delayDry (block, false);
+        chorus.processInPlace (block);
+        return true;
+    }
+
+    // Fully off with the tail gone: nothing left to do but the delay.
+    if (inputGain == 0.0f && target == 0.0f && chorus.isIdle())
+    {
+        delayDry (block, true);
+        return false;
+    }
+
+    const auto numSamples = block.getNumSamples();
+    for (size_t start = 0; start < numSamples; start += (size_t) maxChunkSize)
+        processFade (block.getSubBlock (start, jmin ((size_t) maxChunkSize, numSamples - start)), chorus, target);
+
+    return true;
+}
+
+template <typename SampleType>
+void ChorusBypass<SampleType>::processFade (const dsp::AudioBlock<SampleType>& chunk, ChorusProcessor<SampleType>& chorus,
+                                            float target) noexcept
+{
+    const auto numSamples = (int) chunk.getNumSamples();
+    const auto channels = jmin ((int) chunk.getNumChannels(), numChannels);
+    const auto* gain = inputFade.process (target, numSamples);
+    inputGain = gain[numSamples - 1];
+
+    // The chorus gets the input scaled by the fade. Its output already holds
+    // that much of the dry signal, so the rest is added back afterwards.
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        auto* data = chunk.getChannelPointer ((size_t) ch);
+        FloatVectorOperations::copy (dryChannels[ch], data, numSamples);
+
+        for (int i = 0; i < numSamples; ++i)
+            data[i] *= (SampleType) gain[i];
+    }
+
+    delayDry (dsp::AudioBlock<SampleType> (dryChannels, (size_t) channels, (size_t) numSamples), true);
+    chorus.processInPlace (chunk);
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        auto* data = chunk.getChannelPointer ((size_t) ch);
+        const auto* dry = dryChannels[ch];
+
+        for (int i = 0; i < numSamples; ++i)
+            data[i] += (SampleType) (1.0f - gain[i]) * dry[i];
+    }
+}
+
+template <typename SampleType>
+void ChorusBypass<SampleType>::delayDry (const dsp::AudioBlock<SampleType>& block, bool writeOutput) noexcept
+{
+    if (latency == 0)
+        return;
+
+    const auto numSamples = (int) block.getNumSamples();
+    const auto channels = jmin ((int) block.getNumChannels(), numChannels);
+
+    // Recording a block at least as long as the delay only needs its end.
+    if (! writeOutput && numSamples >= latency)
+    {
+        for (int ch = 0; ch < channels; ++ch)
+            FloatVectorOperations::copy (dryHistory + ch * maxLatency,
+                                         block.getChannelPointer ((size_t) ch) + numSamples - latency, latency);
+
+        historyPos = 0;
+        return;
+    }
+
+    auto pos = historyPos;
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        auto* data = block.getChannelPointer ((size_t) ch);
+        auto* history = dryHistory + ch * maxLatency;
+        pos = historyPos;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto input = data[i];
+
+            if (writeOutput)
+                data[i] = history[pos];
+
+            history[pos] = input;
+
+            if (++pos == latency)
+                pos = 0;
+        }
+    }
+
+    historyPos = pos;
+}
+
+//==============================================================================
+template class ChorusBypass<float>;
+template class ChorusBypass<double>;
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    ChorusBypass.h
+    Click-free bypass for a ChorusProcessor that lets its tail ring out and
+    then stops calling it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChorusProcessor.h"
+
+using namespace juce;
+
+//==============================================================================
+/**
+    Bypasses a ChorusProcessor without cutting off what is still in its
+    delay lines.
+
+    Bypassing fades the chorus's input out over fadeSeconds while the dry
+    signal fades in around it, so the wet signal already in the delay lines
+    and feedback loop plays out over the dry one. Once that tail has
+    decayed below ChorusStateBase::silenceThreshold the chorus isn't called
+    at all, and the block is left as it is. Re-enabling fades the input
+    back in the same way, so neither direction clicks.
+
+    The dry signal is delayed by the latency the host was told about, so it
+    stays aligned with the chorus's output when oversampling is on. That
+    delay is the only work a fully bypassed instance does, and only while
+    the latency isn't 0.
+
+    Only prepare() allocates.
+*/
+template <typename SampleType>
+class ChorusBypass
+{
+public:
+    static constexpr double fadeSeconds = 0.005;
+
+    ChorusBypass() = default;
+
+    /** Message thread: sizes the dry delay and scratch space for spec. If
+        startBypassed is true, processing starts fully bypassed, without a
+        fade.
+    */
+    void prepare (const dsp::ProcessSpec& spec, bool startBypassed);
+
+    /** Audio thread: processes block in place through chorus, or passes it
+        through, fading between the two when shouldBypass changes.
+        latencySamples is the delay the host compensates for. Returns false
+        if the chorus wasn't called.
+    */
+    bool process (const dsp::AudioBlock<SampleType>& block, ChorusProcessor<SampleType>& chorus,
+                  bool shouldBypass, int latencySamples) noexcept;
+
+private:
+    /** Delays block's channels by the latency in place, or, if writeOutput
+        is false, only records them for later blocks.
+    */
+    void delayDry (const dsp::AudioBlock<SampleType>& block, bool writeOutput) noexcept;
+
+    void processFade (const dsp::AudioBlock<SampleType>& chunk, ChorusProcessor<SampleType>& chorus, float target) noexcept;
+
+    ParameterRamp inputFade { ParameterRamp::Mode::linear, fadeSeconds };
+    float inputGain = 1;
+
+    int numChannels = 0;
+    int maxChunkSize = 0;
+    HeapBlock<SampleType> dryBuffer;
+    SampleType* dryChannels[ChorusStateBase::maxChannels] = {};
+
+    // The last `latency` input samples of each channel, oldest at historyPos.
+    int maxLatency = 0;
+    int latency = 0;
+    int historyPos = 0;
+    HeapBlock<SampleType> dryHistory;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChorusBypass)
+};
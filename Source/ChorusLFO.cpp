@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    ChorusLFO.cpp
+    Block-based modulation engine for the chorus.
+
+  ==============================================================================
+*/
+
+#include "ChorusLFO.h"
+
+//==============================================================================
+ChorusLFO::SineTable::SineTable()
+{
+    for (int i = 0; i <= tableSize; i++)
+        values[i] = (float) std::sin (MathConstants<double>::twoPi * i / tableSize);
+}
+
+ChorusLFO::ChorusLFO() = default;
+
+void ChorusLFO::prepare (double sampleRate, int maxBlockSize, int maxTaps)
+{
+    setSampleRate (sampleRate);
+    tapCapacity = maxTaps;
+    output.setSize (maxVoices * maxTaps, jmin (maxBlockSize, maxRenderBlockSize));
+    reset();
+}
+
+void ChorusLFO::reset()
+{
+    phase[0] = 0;
+    cycle[0] = 0;
+    spreadVoicePhases (1);
+    output.clear();
+}
+
+void ChorusLFO::spreadVoicePhases (int firstVoice)
+{
+    for (int v = firstVoice; v < maxVoices; v++)
+    {
+        phase[v] = phase[0] + (double) v / numVoices;
+        cycle[v] = cycle[0];
+        if (phase[v] >= 1)
+        {
+            phase[v] -= 1;
+            cycle[v]++;
+        }
+    }
+}
+
+void ChorusLFO::setRate (float rateHz, int newNumVoices, const float* rateMultipliers)
+{
+    jassert (newNumVoices >= 1 && newNumVoices <= maxVoices);
+
+    if (newNumVoices != numVoices)
+    {
+        // Voices already running keep their phase, or each one's delay would
+        // jump when VOICES is automated. Only the ones switched on are placed.
+        const auto firstNewVoice = numVoices;
+        numVoices = newNumVoices;
+
+        if (numVoices > firstNewVoice)
+            spreadVoicePhases (firstNewVoice);
+    }
+
+    for (int v = 0; v < numVoices; v++)
+        phaseIncrement[v] = rateHz * rateMultipliers[v] * inverseSampleRate;
+}
+
+//==============================================================================
+void ChorusLFO::process (int numSamples, const float* phaseOffsets, int numTaps)
+{
+    jassert (numSamples <= output.getNumSamples() && numTaps <= tapCapacity);
+
+    switch (shape)
+    {
+        case Shape::sine:           processShape<Shape::sine> (numSamples, phaseOffsets, numTaps); break;
+        case Shape::triangle:       processShape<Shape::triangle> (numSamples, phaseOffsets, numTaps); break;
+        case Shape::smoothedRandom: processShape<Shape::smoothedRandom> (numSamples, phaseOffsets, numTaps); break;
+    }
+}
+
+template <ChorusLFO::Shape blockShape>
+void ChorusLFO::processShape (int numSamples, const float* phaseOffsets, int numTaps)
+{
+    auto* const* outputs = output.getArrayOfWritePointers();
+
+    for (int v = 0; v < numVoices; v++)
+    {
+        auto voicePhase = phase[v];
+        auto voiceCycle = cycle[v];
+        const auto increment = phaseIncrement[v];
+        const auto voiceSeed = (uint32) v * 0x9e3779b9u; // decorrelates the random shape
+        auto* const* voiceOutputs = outputs + v * tapCapacity;
+
+        for (int sample = 0; sample < numSamples; sample++)
+        {
+            for (int i = 0; i < numTaps; i++)
+            {
+                auto tapPhase = voicePhase + phaseOffsets[i];
+                auto tapCycle = voiceCycle + voiceSeed;
+                if (tapPhase >= 1)
+                {
+                    tapPhase -= 1;
+                    tapCycle++;
+                }
+
+                if constexpr (blockShape == Shape::sine)
+                    voiceOutputs[i][sample] = sineAt (tapPhase);
+                else if constexpr (blockShape == Shape::triangle)
+                    voiceOutputs[i][sample] = triangleAt (tapPhase);
+                else
+                    voiceOutputs[i][sample] = smoothedRandomAt (tapPhase, tapCycle);
+            }
+
+            voicePhase += increment;
+            if (voicePhase >= 1)
+            {
+                voicePhase -= 1;
+                voiceCycle++;
+            }
+        }
+
+        phase[v] = voicePhase;
+        cycle[v] = voiceCycle;
+    }
+}
+
+//==============================================================================
+float ChorusLFO::sineAt (double tapPhase) const
+{
+    auto position = tapPhase * tableSize;
+    auto index = (int) position;
+    auto frac = (float) (position - index);
+    return sine[index] + frac * (sine[index + 1] - sine[index]);
+}
+
+float ChorusLFO::triangleAt (double tapPhase)
+{
+    // Starts at zero and rises, like the sine.
+    auto shifted = tapPhase + 0.25;
+    if (shifted >= 1)
+        shifted -= 1;
+    return (float) (1.0 - 4.0 * std::abs (shifted - 0.5));
+}
+
+float ChorusLFO::smoothedRandomAt (double tapPhase, uint32 tapCycle)
+{
+    auto valueForCycle = [] (uint32 n)
+    {
+        n ^= n >> 16;
+        n *= 0x7feb352d;
+        n ^= n >> 15;
+        n *= 0x846ca68b;
+        n ^= n >> 16;
+        return (float) n * (2.0f / 4294967295.0f) - 1.0f;
+    };
+
+    auto from = valueForCycle (tapCycle);
+    auto to = valueForCycle (tapCycle + 1);
+    auto t = (float) tapPhase;
+    return from + (to - from) * t * t * (3.0f - 2.0f * t);
+}
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    ChorusLFO.h
+    Block-based modulation engine for the chorus.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace juce;
+
+//==============================================================================
+/**
+    Renders the chorus modulation for a whole block at a time.
+
+    Each chorus voice has its own phase accumulator and rate, kept as
+    structure-of-arrays. Every voice drives several taps that read the
+    waveform at their own phase offset (e.g. the right channel sits
+    PHASEOFFSET cycles ahead of the left). Sine is read from a wavetable
+    that every LFO in the process shares, triangle is computed directly,
+    and the smoothed random shape hashes the cycle count so it is
+    deterministic and consistent across offsets.
+*/
+class ChorusLFO
+{
+public:
+    enum class Shape
+    {
+        sine,
+        triangle,
+        smoothedRandom
+    };
+
+    static constexpr int maxVoices = 8;
+    static constexpr int maxRenderBlockSize = 512;
+    static constexpr int tableSize = 2048;
+
+    ChorusLFO();
+
+    /** Allocates the output buffer for up to maxTaps taps per voice; call from
+        prepareToPlay. Blocks are rendered at most maxRenderBlockSize samples at
+        a time to keep the buffer small for wide channel beds.
+    */
+    void prepare (double sampleRate, int maxBlockSize, int maxTaps);
+    void reset();
+
+    /** Changes the rate the increment is computed for without reallocating. */
+    void setSampleRate (double sampleRate)  { inverseSampleRate = 1.0 / sampleRate; }
+
+    void setShape (Shape newShape)      { shape = newShape; }
+
+    /** Sets the number of voices and each voice's rate as a multiple of
+        rateHz. Voices that are newly switched on start evenly spaced around
+        the cycle from voice 0; voices already running keep their phase.
+    */
+    void setRate (float rateHz, int newNumVoices, const float* rateMultipliers);
+
+    /** Renders numSamples (<= getMaxBlockSize()) into the first numTaps taps
+        of every active voice. Offsets are in cycles.
+    */
+    void process (int numSamples, const float* phaseOffsets, int numTaps);
+
+    const float* getOutput (int voice, int tap) const   { return output.getReadPointer (voice * tapCapacity + tap); }
+    int getMaxBlockSize() const                         { return output.getNumSamples(); }
+
+private:
+    // Built by the first LFO to need it and freed with the last.
+    struct SineTable
+    {
+        SineTable();
+        float values[tableSize + 1];
+    };
+
+    // One instantiation per shape, picked once per block, so the per-sample
+    // loop never tests the shape.
+    template <Shape blockShape>
+    void processShape (int numSamples, const float* phaseOffsets, int numTaps);
+
+    float sineAt (double tapPhase) const;
+    static float triangleAt (double tapPhase);
+    static float smoothedRandomAt (double tapPhase, uint32 tapCycle);
+    void spreadVoicePhases (int firstVoice);
+
+    SharedResourcePointer<SineTable> sineTable;
+    const float* const sine = sineTable->values;
+    AudioBuffer<float> output;
+
+    Shape shape = Shape::sine;
+    double inverseSampleRate = 0;
+    int tapCapacity = 0;
+    int numVoices = 1;
+
+    double phaseIncrement[maxVoices] = {};
+    double phase[maxVoices] = {};
+    uint32 cycle[maxVoices] = {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChorusLFO)
+};
@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    ChorusParameters.cpp
+    Chorus settings, and the per-block ramps handed to the kernel.
+
+  ==============================================================================
+*/
+
+#include "ChorusParameters.h"
+
+//==============================================================================
+ParameterRamp::ParameterRamp (Mode m, double seconds)
+    : mode (m), smoothingSeconds (seconds)
+{
+}
+
+void ParameterRamp::prepare (double sampleRate, float initialValue)
+{
+    linear.reset (sampleRate, smoothingSeconds);
+    linear.setCurrentAndTargetValue (initialValue);
+
+    coefficient = (float) (1.0 - std::exp (-1.0 / (smoothingSeconds * sampleRate)));
+    current = initialValue;
+}
+
+const float* ParameterRamp::process (float target, int numSamples)
+{
+    jassert (numSamples <= maxLength);
+
+    if (mode == Mode::linear)
+    {
+        linear.setTargetValue (target);
+
+        if (linear.isSmoothing())
+            for (int i = 0; i < numSamples; i++)
+                buffer[i] = linear.getNextValue();
+        else
+            FloatVectorOperations::fill (buffer, target, numSamples);
+
+        return buffer;
+    }
+
+    if (std::abs (target - current) > 1.0e-6f)
+    {
+        for (int i = 0; i < numSamples; i++)
+        {
+            current += coefficient * (target - current);
+            buffer[i] = current;
+        }
+    }
+    else
+    {
+        current = target;
+        FloatVectorOperations::fill (buffer, target, numSamples);
+    }
+
+    return buffer;
+}
+
+//==============================================================================
+void ChorusParameterRamps::prepare (double sampleRate, const ChorusSettings& initial)
+{
+    mixRamp.prepare (sampleRate, initial.mix);
+    feedbackRamp.prepare (sampleRate, initial.feedback);
+    depthRamp.prepare (sampleRate, initial.depth);
+}
+
+const ChorusParameters& ChorusParameterRamps::update (const ChorusSettings& targets, int numSamples)
+{
+    params.mix = mixRamp.process (targets.mix, numSamples);
+    params.feedback = feedbackRamp.process (targets.feedback, numSamples);
+    params.depth = depthRamp.process (targets.depth, numSamples);
+
+    params.rate = targets.rate;
+    params.phaseOffset = targets.phaseOffset;
+    params.shape = targets.shape;
+    params.numVoices = targets.numVoices;
+    params.voiceSpread = targets.voiceSpread;
+    params.quality = targets.quality;
+
+    return params;
+}
+
+//==============================================================================
+ChorusParameterSnapshot::ChorusParameterSnapshot (AudioProcessorValueTreeState& apvts)
+    : feedback (*apvts.getRawParameterValue ("FEEDBACK")),
+      mix (*apvts.getRawParameterValue ("MIX")),
+      rate (*apvts.getRawParameterValue ("CHORUSRATE")),
+      depth (*apvts.getRawParameterValue ("CHORUSDEPTH")),
+      phaseOffset (*apvts.getRawParameterValue ("PHASEOFFSET")),
+      shape (*apvts.getRawParameterValue ("LFOSHAPE")),
+      voices (*apvts.getRawParameterValue ("VOICES")),
+      voiceSpread (*apvts.getRawParameterValue ("VOICESPREAD")),
+      quality (*apvts.getRawParameterValue ("QUALITY")),
+      oversampling (*apvts.getRawParameterValue ("OVERSAMPLING")),
+      economy (*apvts.getRawParameterValue ("ECONOMY"))
+{
+}
+
+ChorusSettings ChorusParameterSnapshot::get() const
+{
+    ChorusSettings settings;
+    settings.mix = mix.load();
+    settings.feedback = feedback.load();
+    settings.depth = depth.load();
+    settings.rate = rate.load();
+    settings.phaseOffset = phaseOffset.load();
+    settings.shape = (ChorusLFO::Shape) (int) shape.load();
+    settings.numVoices = (int) voices.load() + 1;
+    settings.voiceSpread = voiceSpread.load();
+    settings.quality = (DelayInterpolation::Quality) (int) quality.load();
+    settings.oversamplingFactor = 1 << (int) oversampling.load();
+    settings.economyFactor = 1 << (int) economy.load();
+    return settings;
+}
@@ -0,0 +1,158 @@
+/*
+  ==============================================================================
+
+    ChorusParameters.h
+    Chorus settings, and the per-block ramps handed to the kernel.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChorusLFO.h"
+#include "DelayInterpolation.h"
+
+using namespace juce;
+
+//==============================================================================
+/**
+    Everything the kernel needs for one block of at most
+    ChorusParameterSnapshot::maxBlockSize samples. Parameters that are audible
+    as zipper noise when they step (mix, feedback, depth) arrive as per-sample
+    ramps; the rest are constant over the block.
+*/
+struct ChorusParameters
+{
+    const float* mix = nullptr;
+    const float* feedback = nullptr;
+    const float* depth = nullptr;
+
+    float rate = 0;
+    float phaseOffset = 0;
+    ChorusLFO::Shape shape = ChorusLFO::Shape::sine;
+    int numVoices = 1;
+    float voiceSpread = 0;
+    DelayInterpolation::Quality quality = DelayInterpolation::Quality::linear;
+};
+
+//==============================================================================
+/**
+    The target value of every chorus setting, in the same units as the
+    plugin's parameters. The defaults match the plugin's.
+*/
+struct ChorusSettings
+{
+    float mix = 0.5f;               // 0 (dry) to 1 (wet)
+    float feedback = 0.35f;         // 0 to 0.98
+    float depth = 0.35f;            // 0 to 1
+    float rate = 0.2f;              // Hz
+    float phaseOffset = 0.2f;       // cycles between channels, 0 to 1
+    ChorusLFO::Shape shape = ChorusLFO::Shape::sine;
+    int numVoices = 1;              // 1 to ChorusLFO::maxVoices
+    float voiceSpread = 0.5f;       // 0 to 1
+    DelayInterpolation::Quality quality = DelayInterpolation::Quality::linear;
+    int oversamplingFactor = 1;     // 1, 2 or 4
+    int economyFactor = 1;          // 1, 2 or 4: the wet path runs at 1/factor of the rate; ignored when oversampling
+};
+
+//==============================================================================
+/**
+    Smooths one parameter into a fixed-size buffer of per-sample values.
+*/
+class ParameterRamp
+{
+public:
+    enum class Mode
+    {
+        linear,
+        onePole
+    };
+
+    static constexpr int maxLength = ChorusLFO::maxRenderBlockSize;
+
+    ParameterRamp (Mode mode, double smoothingSeconds);
+
+    /** Sets the smoothing time for this rate and jumps to the target. */
+    void prepare (double sampleRate, float initialValue);
+
+    /** Ramps from the current value towards target over numSamples. */
+    const float* process (float target, int numSamples);
+
+private:
+    const Mode mode;
+    const double smoothingSeconds;
+
+    SmoothedValue<float, ValueSmoothingTypes::Linear> linear;
+    float current = 0;
+    float coefficient = 1;
+
+    float buffer[maxLength];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParameterRamp)
+};
+
+//==============================================================================
+/**
+    Turns ChorusSettings into a ChorusParameters for each block, smoothing
+    the settings that would zipper into per-sample ramps.
+*/
+class ChorusParameterRamps
+{
+public:
+    static constexpr int maxBlockSize = ParameterRamp::maxLength;
+
+    /** The mix ramp is linear, so it reaches a new target within this time. */
+    static constexpr double mixSmoothingSeconds = 0.02;
+
+    ChorusParameterRamps() = default;
+
+    /** Jumps the ramps to these settings for this rate. Doesn't allocate, so
+        the audio thread calls it too when the kernel rate changes with the
+        oversampling factor.
+    */
+    void prepare (double sampleRate, const ChorusSettings& initial);
+
+    /** Renders the ramps towards targets for the next numSamples
+        (<= maxBlockSize).
+    */
+    const ChorusParameters& update (const ChorusSettings& targets, int numSamples);
+
+private:
+    ParameterRamp mixRamp { ParameterRamp::Mode::linear, mixSmoothingSeconds };
+    ParameterRamp feedbackRamp { ParameterRamp::Mode::onePole, 0.02 };
+    ParameterRamp depthRamp { ParameterRamp::Mode::onePole, 0.05 };
+
+    ChorusParameters params;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChorusParameterRamps)
+};
+
+//==============================================================================
+/**
+    Resolves the parameter atomics once and reads them into a ChorusSettings
+    for each block without touching the parameter tree's string lookups.
+*/
+class ChorusParameterSnapshot
+{
+public:
+    explicit ChorusParameterSnapshot (AudioProcessorValueTreeState& apvts);
+
+    /** Any thread: the current value of every parameter. */
+    ChorusSettings get() const;
+
+private:
+    std::atomic<float>& feedback;
+    std::atomic<float>& mix;
+    std::atomic<float>& rate;
+    std::atomic<float>& depth;
+    std::atomic<float>& phaseOffset;
+    std::atomic<float>& shape;
+    std::atomic<float>& voices;
+    std::atomic<float>& voiceSpread;
+    std::atomic<float>& quality;
+    std::atomic<float>& oversampling;
+    std::atomic<float>& economy;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChorusParameterSnapshot)
+};
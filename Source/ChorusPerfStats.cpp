@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    ChorusPerfStats.cpp
+    Per-block timing, load and overrun counters for processBlock.
+
+  ==============================================================================
+*/
+
+#include "ChorusPerfStats.h"
+
+//==============================================================================
+void ChorusPerfStats::prepare (double sampleRate)
+{
+    ticksPerSample.store ((double) Time::getHighResolutionTicksPerSecond() / sampleRate);
+}
+
+void ChorusPerfStats::addBlock (int64 elapsedTicks, int numSamples)
+{
+    const auto budget = ticksPerSample.load (std::memory_order_relaxed) * numSamples;
+    if (budget <= 0)
+        return;
+
+    const auto load = (double) elapsedTicks / budget;
+
+    increment (blocks);
+    if (load > 1.0)
+        increment (overruns);
+
+    totalTicks.store (totalTicks.load (std::memory_order_relaxed) + (uint64) elapsedTicks, std::memory_order_relaxed);
+    totalBudgetTicks.store (totalBudgetTicks.load (std::memory_order_relaxed) + budget, std::memory_order_relaxed);
+    lastLoad.store (load, std::memory_order_relaxed);
+
+    if (load > peakLoad.load (std::memory_order_relaxed))
+        peakLoad.store (load, std::memory_order_relaxed);
+
+    const auto micros = (double) elapsedTicks * 1.0e6 / (double) Time::getHighResolutionTicksPerSecond();
+    int bin = 0;
+    while (bin < numBins - 1 && micros >= getBinLimitMicros (bin))
+        bin++;
+
+    increment (histogram[bin]);
+}
+
+void ChorusPerfStats::reset()
+{
+    blocks.store (0);
+    overruns.store (0);
+    totalTicks.store (0);
+    totalBudgetTicks.store (0);
+    lastLoad.store (0);
+    peakLoad.store (0);
+
+    for (auto& bin : histogram)
+        bin.store (0);
+}
+
+ChorusPerfStats::Snapshot ChorusPerfStats::getSnapshot() const
+{
+    Snapshot snapshot;
+    snapshot.blocks = blocks.load (std::memory_order_relaxed);
+    snapshot.overruns = overruns.load (std::memory_order_relaxed);
+    snapshot.lastLoad = lastLoad.load (std::memory_order_relaxed);
+    snapshot.peakLoad = peakLoad.load (std::memory_order_relaxed);
+
+    const auto budget = totalBudgetTicks.load (std::memory_order_relaxed);
+    snapshot.averageLoad = budget > 0 ? (double) totalTicks.load (std::memory_order_relaxed) / budget : 0.0;
+
+    for (int i = 0; i < numBins; i++)
+        snapshot.histogram[i] = histogram[i].load (std::memory_order_relaxed);
+
+    return snapshot;
+}
+
+var ChorusPerfStats::toVar() const
+{
+    const auto snapshot = getSnapshot();
+
+    Array<var> bins;
+    for (int i = 0; i < numBins; i++)
+    {
+        if (snapshot.histogram[i] == 0)
+            continue;
+
+        auto* bin = new DynamicObject();
+        bin->setProperty ("belowMicros", i < numBins - 1 ? var (getBinLimitMicros (i)) : var ("inf"));
+        bin->setProperty ("blocks", (int64) snapshot.histogram[i]);
+        bins.add (var (bin));
+    }
+
+    auto* result = new DynamicObject();
+    result->setProperty ("blocks", (int64) snapshot.blocks);
+    result->setProperty ("overruns", (int64) snapshot.overruns);
+    result->setProperty ("lastLoad", snapshot.lastLoad);
+    result->setProperty ("peakLoad", snapshot.peakLoad);
+    result->setProperty ("averageLoad", snapshot.averageLoad);
+    result->setProperty ("histogram", bins);
+    return var (result);
+}
+
+double ChorusPerfStats::getBinLimitMicros (int bin)
+{
+    return std::ldexp (1.0, bin);
+}
@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    ChorusPerfStats.h
+    Per-block timing, load and overrun counters for processBlock.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/** Compiles the per-block instrumentation into processBlock. It is on in
+    debug builds only; set it to 1 in the Projucer's preprocessor
+    definitions to keep it in a release build, as the bench, render and
+    real-time check tools do.
+*/
+#ifndef EZ_CHORUS_PERF_STATS
+ #if JUCE_DEBUG
+  #define EZ_CHORUS_PERF_STATS 1
+ #else
+  #define EZ_CHORUS_PERF_STATS 0
+ #endif
+#endif
+
+using namespace juce;
+
+//==============================================================================
+/**
+    Collects processBlock timings on the audio thread and lets any other
+    thread read them without locking.
+
+    Every counter has a single writer (the audio thread), so updates are plain
+    relaxed loads and stores; readers may see a snapshot that is a block out
+    of date, which is fine for monitoring.
+*/
+class ChorusPerfStats
+{
+public:
+    /** Block durations go into power-of-two microsecond bins: bin 0 holds
+        blocks under 1 us, bin i blocks from 2^(i-1) to 2^i us, and the last
+        bin everything longer.
+    */
+    static constexpr int numBins = 24;
+
+    struct Snapshot
+    {
+        uint64 blocks = 0;
+        uint64 overruns = 0;
+        double lastLoad = 0;
+        double peakLoad = 0;
+        double averageLoad = 0;
+        uint64 histogram[numBins] = {};
+    };
+
+    ChorusPerfStats() = default;
+
+    /** Message thread: sets the rate used to work out each block's budget. */
+    void prepare (double sampleRate);
+
+    /** Audio thread: records one block that took elapsedTicks of
+        Time::getHighResolutionTicks() to process numSamples.
+    */
+    void addBlock (int64 elapsedTicks, int numSamples);
+
+    /** Any thread: clears the counters. Blocks processed concurrently may be
+        partly counted.
+    */
+    void reset();
+
+    /** Any thread. */
+    Snapshot getSnapshot() const;
+
+    /** Any thread: the current counters as a JSON-friendly object, for the
+        headless tools.
+    */
+    var toVar() const;
+
+    /** Upper edge of a histogram bin in microseconds. */
+    static double getBinLimitMicros (int bin);
+
+    //==============================================================================
+    /** Times the enclosing scope and adds it as one block. */
+    class ScopedBlockTimer
+    {
+    public:
+        ScopedBlockTimer (ChorusPerfStats& s, int n)
+            : stats (s), numSamples (n), start (Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedBlockTimer()
+        {
+            stats.addBlock (Time::getHighResolutionTicks() - start, numSamples);
+        }
+
+    private:
+        ChorusPerfStats& stats;
+        const int numSamples;
+        const int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedBlockTimer)
+    };
+
+private:
+    static void increment (std::atomic<uint64>& counter)
+    {
+        counter.store (counter.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::atomic<double> ticksPerSample { 0 };
+
+    std::atomic<uint64> blocks { 0 };
+    std::atomic<uint64> overruns { 0 };
+    std::atomic<uint64> totalTicks { 0 };
+    std::atomic<double> totalBudgetTicks { 0 };
+    std::atomic<double> lastLoad { 0 };
+    std::atomic<double> peakLoad { 0 };
+    std::atomic<uint64> histogram[numBins] {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChorusPerfStats)
+};
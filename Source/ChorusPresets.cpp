@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    ChorusPresets.cpp
+    The built-in preset bank, and the compact binary format the plugin
+    saves its state in.
+
+  ==============================================================================
+*/
+
+#include "ChorusPresets.h"
+
+namespace ChorusPresets
+{
+
+// Append only: the index of each ID is its position in every saved state.
+// Presets stop before BYPASS.
+const char* const parameterIDs[numParameters] =
+{
+    "FEEDBACK", "PHASEOFFSET", "MIX", "CHORUSDEPTH", "CHORUSRATE", "LFOSHAPE",
+    "VOICES", "VOICESPREAD", "QUALITY", "OVERSAMPLING", "ECONOMY", "BYPASS"
+};
+
+static const Preset presets[] =
+{
+    //                      feedback offset mix    depth  rate   shape voices spread quality os  economy
+    { "Default",          { 0.35f,   0.2f,  0.5f,  0.35f, 0.2f,  0,    0,     0.5f,  0,      0,  0 } },
+    { "Subtle Doubler",   { 0.0f,    0.5f,  0.35f, 0.15f, 0.3f,  0,    1,     0.3f,  1,      0,  0 } },
+    { "Wide Ensemble",    { 0.2f,    0.5f,  0.5f,  0.5f,  0.6f,  0,    3,     0.8f,  1,      0,  0 } },
+    { "Lush Eight",       { 0.3f,    0.5f,  0.5f,  0.6f,  0.35f, 0,    7,     1.0f,  2,      0,  0 } },
+    { "Jet Feedback",     { 0.9f,    0.25f, 0.5f,  0.8f,  0.1f,  1,    0,     0.5f,  3,      1,  0 } },
+    { "Tape Warble",      { 0.1f,    0.0f,  1.0f,  0.3f,  4.5f,  2,    0,     0.5f,  1,      0,  0 } },
+    { "Vibrato",          { 0.0f,    0.0f,  1.0f,  0.25f, 5.0f,  0,    0,     0.5f,  1,      0,  0 } },
+    { "Economy Ensemble", { 0.2f,    0.5f,  0.5f,  0.5f,  0.6f,  0,    3,     0.8f,  1,      0,  1 } },
+};
+
+// "EZCS" read as a little-endian int. The XML states written by
+// copyXmlToBinary start with a different magic number.
+static constexpr int stateMagic = 0x53435a45;
+static constexpr int stateVersion = 1;
+static constexpr int headerSize = 4 * (int) sizeof (int32);
+
+//==============================================================================
+int getNumPresets()
+{
+    return numElementsInArray (presets);
+}
+
+const Preset& getPreset (int index)
+{
+    return presets[jlimit (0, getNumPresets() - 1, index)];
+}
+
+void apply (const Preset& preset, AudioProcessorValueTreeState& apvts)
+{
+    for (int i = 0; i < numPresetParameters; i++)
+        if (auto* param = apvts.getParameter (parameterIDs[i]))
+            param->setValueNotifyingHost (param->convertTo0to1 (preset.values[i]));
+}
+
+//==============================================================================
+void writeState (AudioProcessorValueTreeState& apvts, int currentProgram, MemoryBlock& dest)
+{
+    MemoryOutputStream out (dest, true);
+    out.writeInt (stateMagic);
+    out.writeInt (stateVersion);
+    out.writeInt (currentProgram);
+    out.writeInt (numParameters);
+
+    for (auto* id : parameterIDs)
+        out.writeFloat (apvts.getRawParameterValue (id)->load());
+}
+
+bool readState (const void* data, int sizeInBytes, AudioProcessorValueTreeState& apvts, int& currentProgram)
+{
+    if (data == nullptr || sizeInBytes < headerSize)
+        return false;
+
+    MemoryInputStream in (data, (size_t) sizeInBytes, false);
+
+    if (in.readInt() != stateMagic || in.readInt() < 1)
+        return false;
+
+    const auto program = in.readInt();
+    const auto numValues = in.readInt();
+
+    if (numValues < 0 || in.getNumBytesRemaining() < (int64) numValues * (int64) sizeof (float))
+        return false;
+
+    for (int i = 0; i < numParameters; i++)
+    {
+        const auto hasValue = i < numValues;
+        const auto value = hasValue ? in.readFloat() : 0.0f;
+
+        if (auto* param = apvts.getParameter (parameterIDs[i]))
+            param->setValueNotifyingHost (hasValue ? param->convertTo0to1 (value) : param->getDefaultValue());
+    }
+
+    currentProgram = jlimit (0, getNumPresets() - 1, program);
+    return true;
+}
+
+}
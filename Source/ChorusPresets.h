@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    ChorusPresets.h
+    The built-in preset bank, and the compact binary format the plugin
+    saves its state in.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace juce;
+
+//==============================================================================
+/**
+    Parameter values as plain data. Presets and saved states both list
+    parameters in the order of parameterIDs, in the parameter's own units
+    (choices and switches by index). Saved states hold every parameter.
+    Presets hold the first numPresetParameters, so a program change leaves
+    bypass alone.
+
+    The binary state is a header (magic, format version, current program,
+    value count) followed by the values as little-endian floats. Restoring
+    one touches no XML or ValueTree and allocates nothing. Parameters are
+    only ever appended to parameterIDs. A state from an older build that
+    has fewer values resets the rest to their defaults, and values a newer
+    build added are skipped.
+*/
+namespace ChorusPresets
+{
+    static constexpr int numParameters = 12;
+    static constexpr int numPresetParameters = 11;
+    extern const char* const parameterIDs[numParameters];
+
+    struct Preset
+    {
+        const char* name;
+        float values[numPresetParameters];
+    };
+
+    int getNumPresets();
+    const Preset& getPreset (int index);
+
+    /** Message thread: sets every parameter to the preset's value. */
+    void apply (const Preset& preset, AudioProcessorValueTreeState& apvts);
+
+    /** Appends the current parameter values and program number to dest. */
+    void writeState (AudioProcessorValueTreeState& apvts, int currentProgram, MemoryBlock& dest);
+
+    /** Message thread: restores a state written by writeState(). Returns
+        false without changing anything if the data isn't in the binary
+        format, e.g. an XML state saved by an older build.
+    */
+    bool readState (const void* data, int sizeInBytes, AudioProcessorValueTreeState& apvts, int& currentProgram);
+}
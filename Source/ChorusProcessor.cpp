@@ -0,0 +1,213 @@
+/*
+  ==============================================================================
+
+    ChorusProcessor.cpp
+    The chorus as a juce::dsp processor, independent of the plugin.
+
+  ==============================================================================
+*/
+
+#include "ChorusProcessor.h"
+
+//==============================================================================
+template <typename SampleType>
+ChorusProcessor<SampleType>::ChorusProcessor()
+{
+    FloatVectorOperations::fill (fullyWet, 1.0f, ChorusParameterRamps::maxBlockSize);
+}
+
+template <typename SampleType>
+void ChorusProcessor<SampleType>::prepare (const dsp::ProcessSpec& spec, int maxConcurrency)
+{
+    preparedSpec = spec;
+    preparedConcurrency = maxConcurrency;
+    preparedOversampling = settings.oversamplingFactor;
+    requestedOversampling.store (0);
+
+    // Allocates only if the current state is too small for this rate, block
+    // size, channel count or oversampling factor; otherwise the audio thread
+    // retunes it in place.
+    stateSwap.prepare (spec.sampleRate, (int) spec.maximumBlockSize,
+                       jmin ((int) spec.numChannels, ChorusStateBase::maxChannels), maxConcurrency,
+                       preparedOversampling, delayStorage);
+}
+
+template <typename SampleType>
+void ChorusProcessor<SampleType>::prepareForOversampling()
+{
+    const auto factor = requestedOversampling.exchange (0, std::memory_order_relaxed);
+
+    if (factor <= preparedOversampling)
+        return;
+
+    preparedOversampling = factor;
+    stateSwap.prepare (preparedSpec.sampleRate, (int) preparedSpec.maximumBlockSize,
+                       jmin ((int) preparedSpec.numChannels, ChorusStateBase::maxChannels), preparedConcurrency,
+                       preparedOversampling, delayStorage);
+}
+
+template <typename SampleType>
+void ChorusProcessor<SampleType>::reset()
+{
+    state = stateSwap.acquire();
+
+    if (state != nullptr)
+    {
+        state->reset();
+        kernelRate = state->getKernelRate();
+        ramps.prepare (kernelRate, settings);
+        hostMixRamp.prepare (state->getSampleRate(), settings.mix);
+    }
+
+    inputPeak = outputPeak = wetPeak = 0;
+}
+
+template <typename SampleType>
+void ChorusProcessor<SampleType>::processInPlace (const dsp::AudioBlock<SampleType>& hostBlock) noexcept
+{
+    state = stateSwap.acquire();
+    if (state == nullptr)
+        return;
+
+    // Changing the kernel rate clears the delay lines and restarts the ramps
+    // at the new rate. A retune from prepare() is picked up the same way.
+    // Oversampling takes precedence over economy mode.
+    const auto economyFactor = settings.oversamplingFactor > 1 ? 1 : settings.economyFactor;
+
+    if (settings.oversamplingFactor != state->getOversamplingFactor())
+    {
+        state->setOversampling (settings.oversamplingFactor);
+
+        // Building a bigger state allocates, so leave it to the message thread.
+        if (settings.oversamplingFactor > state->getOversamplingFactor())
+            requestedOversampling.store (settings.oversamplingFactor, std::memory_order_relaxed);
+    }
+
+    if (economyFactor != state->getEconomyFactor())
+        state->setEconomyFactor (economyFactor);
+
+    const auto rate = state->getKernelRate();
+    if (rate != kernelRate)
+    {
+        kernelRate = rate;
+        ramps.prepare (kernelRate, settings);
+        hostMixRamp.prepare (state->getSampleRate(), settings.mix);
+    }
+
+    latencySamples = state->getLatencySamples();
+    wetPeak = 0;
+
+    const auto numChannels = jmin ((int) hostBlock.getNumChannels(), ChorusStateBase::maxChannels);
+    const auto numHostSamples = (int) hostBlock.getNumSamples();
+    auto block = hostBlock.getSubsetChannelBlock (0, (size_t) numChannels);
+
+    if (metering || state->isIdle())
+        inputPeak = getPeak (block);
+
+    // Once the tail has rung out and the lines are clear, silent input needs
+    // no processing at all: the output is the input.
+    if (state->isIdle() && inputPeak <= ChorusStateBase::silenceThreshold)
+    {
+        outputPeak = inputPeak;
+        return;
+    }
+
+    SampleType* channels[ChorusStateBase::maxChannels];
+
+    for (int hostStart = 0; hostStart < numHostSamples; hostStart += state->getMaxBlockSize())
+    {
+        auto subBlock = block.getSubBlock ((size_t) hostStart, (size_t) jmin (state->getMaxBlockSize(), numHostSamples - hostStart));
+
+        if (state->getEconomyFactor() > 1)
+        {
+            processReducedRate (subBlock);
+            continue;
+        }
+
+        auto kernelBlock = state->upsample (subBlock);
+        const auto kernelSamples = (int) kernelBlock.getNumSamples();
+
+        // Settings are read once per sub-block and smoothed into per-sample
+        // ramps, so automation doesn't zipper and the kernel stays vectorised.
+        for (int start = 0; start < kernelSamples; start += ChorusParameterRamps::maxBlockSize)
+        {
+            const auto numSamples = jmin (ChorusParameterRamps::maxBlockSize, kernelSamples - start);
+            const auto& params = ramps.update (settings, numSamples);
+
+            for (int ch = 0; ch < numChannels; ch++)
+                channels[ch] = kernelBlock.getChannelPointer ((size_t) ch) + start;
+
+            state->process (channels, numChannels, numSamples, params, workers);
+            wetPeak = jmax (wetPeak, state->getWetPeak());
+        }
+
+        state->downsample (subBlock);
+    }
+
+    if (metering)
+        outputPeak = getPeak (block);
+}
+
+template <typename SampleType>
+void ChorusProcessor<SampleType>::processReducedRate (dsp::AudioBlock<SampleType>& block)
+{
+    SampleType* channels[ChorusStateBase::maxChannels];
+
+    auto reducedBlock = state->decimate (block);
+    const auto numChannels = (int) reducedBlock.getNumChannels();
+    const auto reducedSamples = (int) reducedBlock.getNumSamples();
+
+    // The kernel produces the wet signal alone; the dry signal never leaves
+    // the host rate.
+    for (int start = 0; start < reducedSamples; start += ChorusParameterRamps::maxBlockSize)
+    {
+        const auto numSamples = jmin (ChorusParameterRamps::maxBlockSize, reducedSamples - start);
+        auto params = ramps.update (settings, numSamples);
+        params.mix = fullyWet;
+
+        for (int ch = 0; ch < numChannels; ch++)
+            channels[ch] = reducedBlock.getChannelPointer ((size_t) ch) + start;
+
+        state->process (channels, numChannels, numSamples, params, workers);
+        wetPeak = jmax (wetPeak, state->getWetPeak());
+    }
+
+    const auto numHostSamples = (int) block.getNumSamples();
+    const auto wetBlock = state->interpolate (numHostSamples);
+
+    // out = in + mix * (wet - in)
+    for (int start = 0; start < numHostSamples; start += ParameterRamp::maxLength)
+    {
+        const auto numSamples = jmin (ParameterRamp::maxLength, numHostSamples - start);
+        const auto* mix = hostMixRamp.process (settings.mix, numSamples);
+
+        for (int ch = 0; ch < numChannels; ch++)
+        {
+            auto* out = block.getChannelPointer ((size_t) ch) + start;
+            const auto* wet = wetBlock.getChannelPointer ((size_t) ch) + start;
+
+            for (int i = 0; i < numSamples; i++)
+                out[i] += (SampleType) mix[i] * (wet[i] - out[i]);
+        }
+    }
+}
+
+template <typename SampleType>
+void ChorusProcessor<SampleType>::fillTelemetry (ChorusTelemetry::Frame& frame) const
+{
+    if (state != nullptr)
+        state->fillTelemetry (frame);
+    else
+        frame.numChannels = 0;
+}
+
+template <typename SampleType>
+float ChorusProcessor<SampleType>::getPeak (const dsp::AudioBlock<SampleType>& block)
+{
+    const auto range = block.findMinAndMax();
+    return (float) jmax (range.getEnd(), -range.getStart());
+}
+
+//==============================================================================
+template class ChorusProcessor<float>;
+template class ChorusProcessor<double>;
@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+
+    ChorusProcessor.h
+    The chorus as a juce::dsp processor, independent of the plugin.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChorusState.h"
+
+using namespace juce;
+
+//==============================================================================
+/**
+    The whole EZ Chorus effect as a juce::dsp-style processor. It offers
+    prepare(), reset() and process() over a ProcessContextReplacing or
+    ProcessContextNonReplacing, so it can sit in a dsp::ProcessorChain or in
+    any graph that hands it AudioBlocks.
+
+    Processing happens in place on the block it is given, which may be a
+    sub-block of a larger buffer, with no copies in or out. A non-replacing
+    context copies its input to its output first. Blocks longer than the
+    prepared maximum are split internally. Channels beyond
+    ChorusStateBase::maxChannels pass through dry.
+
+    Settings are plain values set on the audio thread before process(). Mix,
+    feedback and depth are smoothed, so they can change every block.
+    Changing the oversampling factor clears the delay lines and changes
+    getLatencySamples(). Changing the economy factor clears the delay lines
+    but adds no latency.
+
+    The state is only built for the oversampling factor in the settings at
+    prepare() time. A higher factor set later runs at the highest one the
+    state can manage until prepareForOversampling() has built a bigger one.
+
+    Only prepare() allocates. It is meant for the message thread, and the
+    state it builds is handed to process() without locking (see
+    ChorusStateSwap).
+*/
+template <typename SampleType>
+class ChorusProcessor
+{
+public:
+    ChorusProcessor();
+
+    /** Builds delay lines and filters for up to spec.numChannels channels of
+        spec.maximumBlockSize samples at spec.sampleRate, and the current
+        settings' oversampling factor. maxConcurrency is the number of
+        threads that may process one block together: the workers of the
+        pool passed to setWorkerPool(), plus one.
+    */
+    void prepare (const dsp::ProcessSpec& spec, int maxConcurrency = 1);
+
+    /** Message thread: if process() has been asked for a higher oversampling
+        factor than the state was built for, builds one that can run it with
+        the last prepare()'s spec. Cheap otherwise, so it can be polled.
+    */
+    void prepareForOversampling();
+
+    /** Audio thread: clears the delay lines and filters, and jumps the
+        smoothed settings to their targets.
+    */
+    void reset();
+
+    /** Message thread: frees any state that a later prepare() replaced. */
+    void collectGarbage()                               { stateSwap.collectGarbage(); }
+
+    /** Audio thread: the settings to use from the next process() call on. */
+    void setSettings (const ChorusSettings& newSettings) { settings = newSettings; }
+    const ChorusSettings& getSettings() const           { return settings; }
+
+    /** Shares each block's channels out over the pool's threads. Pass
+        nullptr to process every channel on the calling thread. The pool
+        blocks between batches, so use it for offline rendering only.
+    */
+    void setWorkerPool (ChannelWorkerPool* pool)        { workers = pool; }
+
+    /** When enabled, each process() call records the input, output and wet
+        peak levels. Off by default. With it off, only the wet peak and the
+        idle check's input peak are computed.
+    */
+    void setMeteringEnabled (bool shouldMeter)          { metering = shouldMeter; }
+
+    /** Message thread: how the delay lines store their samples, from the
+        next prepare() on. DelayStorage::half halves their memory (quarters
+        it for double) at the cost of a noise floor 64 to 76 dB below the
+        signal, depending on the feedback; see HalfFloat.
+    */
+    void setDelayStorage (DelayStorage storage)         { delayStorage = storage; }
+    DelayStorage getDelayStorage() const                { return delayStorage; }
+
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        static_assert (std::is_same_v<typename ProcessContext::SampleType, SampleType>,
+                       "The context's sample type must match the processor's");
+
+        auto& outputBlock = context.getOutputBlock();
+
+        if (context.usesSeparateInputAndOutputBlocks())
+            outputBlock.copyFrom (context.getInputBlock());
+
+        if (context.isBypassed)
+            return;
+
+        processInPlace (outputBlock);
+    }
+
+    /** Processes every channel of block in place. */
+    void processInPlace (const dsp::AudioBlock<SampleType>& block) noexcept;
+
+    /** The delay in samples that the current oversampling factor adds. It
+        is updated by process().
+    */
+    int getLatencySamples() const       { return latencySamples; }
+
+    /** True while process() has nothing to do for silent input. */
+    bool isIdle() const                 { return state == nullptr || state->isIdle(); }
+
+    /** Peak levels over the last process() call. The input and output
+        peaks need metering to be enabled.
+    */
+    float getInputPeak() const          { return inputPeak; }
+    float getOutputPeak() const         { return outputPeak; }
+    float getWetPeak() const            { return wetPeak; }
+
+    /** Audio thread: writes each channel's LFO position and delay at the end
+        of the last process() call into frame.
+    */
+    void fillTelemetry (ChorusTelemetry::Frame& frame) const;
+
+private:
+    static float getPeak (const dsp::AudioBlock<SampleType>& block);
+
+    /** Economy mode: runs the kernel on a decimated copy of block and mixes
+        the interpolated wet signal into it at the host rate.
+    */
+    void processReducedRate (dsp::AudioBlock<SampleType>& block);
+
+    ChorusStateSwap<SampleType> stateSwap;
+    ChorusState<SampleType>* state = nullptr;   // the one acquired for the last block
+    ChorusParameterRamps ramps;
+    ParameterRamp hostMixRamp { ParameterRamp::Mode::linear, ChorusParameterRamps::mixSmoothingSeconds };   // economy mode mixes at the host rate
+    float fullyWet[ChorusParameterRamps::maxBlockSize];
+    ChorusSettings settings;
+    ChannelWorkerPool* workers = nullptr;
+    DelayStorage delayStorage = DelayStorage::full;
+
+    dsp::ProcessSpec preparedSpec {};
+    int preparedConcurrency = 1;
+    int preparedOversampling = 1;
+    std::atomic<int> requestedOversampling { 0 };   // set by process() when the state is too small
+
+    double kernelRate = 0;
+    int latencySamples = 0;
+    bool metering = false;
+    float inputPeak = 0;
+    float outputPeak = 0;
+    float wetPeak = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChorusProcessor)
+};
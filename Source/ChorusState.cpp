@@ -0,0 +1,695 @@
+/*
+  ==============================================================================
+
+    ChorusState.cpp
+    All of the chorus DSP state for one sample-rate/block-size configuration,
+    and the lock-free handoff that swaps it in on the audio thread.
+
+  ==============================================================================
+*/
+
+#include "ChorusState.h"
+
+//==============================================================================
+double ChorusStateBase::getTailLengthSeconds (float feedbackGain)
+{
+    // Each trip round the loop takes at most the longest delay and is scaled
+    // by at most the feedback gain, since the voices are averaged.
+    if (feedbackGain <= silenceThreshold)
+        return maxDelaySeconds;
+
+    const auto trips = std::ceil (std::log (silenceThreshold) / std::log (jmin (feedbackGain, 0.999f)));
+    return maxDelaySeconds * (trips + 1.0);
+}
+
+int ChorusStateBase::getOversamplingLatency (int factor)
+{
+    if (factor <= 1)
+        return 0;
+
+    dsp::Oversampling<float> stage (1, (size_t) roundToInt (std::log2 (factor)),
+                                    dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, false, true);
+    return roundToInt (stage.getLatencyInSamples());
+}
+
+int ChorusStateBase::maxDelaySamplesFor (double rate)
+{
+    // The longest modulated delay plus the older interpolation neighbours.
+    return (int) std::ceil (rate * maxDelaySeconds) + 2;
+}
+
+//==============================================================================
+template <typename SampleType>
+ChorusState<SampleType>::ChorusState (double initialSampleRate, int maxBlockSize, int numChannels, int maxConcurrency,
+                                      int maxOversampling, DelayStorage delayStorage)
+    : capacityBlockSize (maxBlockSize),
+      capacityChannels (jlimit (1, maxChannels, numChannels)),
+      capacityConcurrency (jmax (1, maxConcurrency)),
+      capacityOversampling (jlimit (1, maxOversamplingFactor, nextPowerOfTwo (maxOversampling))),
+      storage (delayStorage)
+{
+    for (int i = 0; i < maxChunkSize; i++)
+        rampChunk[i] = (float) i;
+
+    lfo.prepare (initialSampleRate, maxBlockSize, capacityChannels);
+
+    // Delay lines are sized for the highest kernel rate this state can run,
+    // so the oversampling factor can change up to it without reallocating.
+    const auto maxDelaySamples = maxDelaySamplesFor (initialSampleRate * capacityOversampling);
+
+    for (int ch = 0; ch < capacityChannels; ch++)
+    {
+        if (storage == DelayStorage::half)
+            compactLines.add (new ModulatedDelayLine<SampleType, uint16>())->prepare (maxDelaySamples);
+        else
+            delayLines.add (new ModulatedDelayLine<SampleType>())->prepare (maxDelaySamples);
+    }
+
+    chunkKernel = storage == DelayStorage::half ? getChunkKernel<uint16> (quality)
+                                                : getChunkKernel<SampleType> (quality);
+
+    for (int stages = 1; (1 << stages) <= capacityOversampling; stages++)
+    {
+        auto* stage = oversamplers.add (new dsp::Oversampling<SampleType> ((size_t) capacityChannels, (size_t) stages,
+                                                                           dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR,
+                                                                           false, true));
+        stage->initProcessing ((size_t) maxBlockSize);
+    }
+
+    // Two buffers of host-rate blocks: the reduced-rate signal and the
+    // interpolated wet signal take turns in them.
+    for (auto& stage : economyStages)
+        stage.prepare (capacityChannels);
+
+    economyBuffers.calloc ((size_t) (2 * capacityChannels * maxBlockSize));
+
+    for (int buffer = 0; buffer < 2; buffer++)
+        for (int ch = 0; ch < capacityChannels; ch++)
+            economyChannels[buffer][ch] = economyBuffers + (buffer * capacityChannels + ch) * maxBlockSize;
+
+    feedback.calloc ((size_t) capacityChannels);
+    channelPhaseOffsets.calloc ((size_t) capacityChannels);
+    scratch.calloc ((size_t) capacityConcurrency);
+
+    configure (initialSampleRate);
+}
+
+template <typename SampleType>
+bool ChorusState<SampleType>::canRunAt (double newSampleRate, int blockSize, int numChannels, int concurrency,
+                                        int oversampling) const
+{
+    return blockSize <= capacityBlockSize
+        && numChannels <= capacityChannels
+        && concurrency <= capacityConcurrency
+        && oversampling <= capacityOversampling
+        && linesCanHold (newSampleRate * oversampling);
+}
+
+template <typename SampleType>
+bool ChorusState<SampleType>::linesCanHold (double kernelRate) const
+{
+    return storage == DelayStorage::half ? compactLines.getFirst()->canHold (maxDelaySamplesFor (kernelRate))
+                                         : delayLines.getFirst()->canHold (maxDelaySamplesFor (kernelRate));
+}
+
+template <typename SampleType>
+size_t ChorusState<SampleType>::getDelayMemoryBytes() const
+{
+    size_t total = 0;
+
+    for (auto* line : delayLines)
+        total += line->getSizeInBytes();
+
+    for (auto* line : compactLines)
+        total += line->getSizeInBytes();
+
+    return total;
+}
+
+template <typename SampleType>
+void ChorusState<SampleType>::configure (double newSampleRate)
+{
+    jassert (canRunAt (newSampleRate, 0, 0, 0));
+
+    sampleRate = newSampleRate;
+
+    // A state retuned to a higher rate may no longer fit the current factor.
+    if (const auto maxFactor = getMaxOversamplingFactor(); oversamplingFactor > maxFactor)
+    {
+        oversamplingFactor = maxFactor;
+        oversampler = maxFactor > 1 ? oversamplers[roundToInt (std::log2 (maxFactor)) - 1] : nullptr;
+    }
+
+    const auto kernelRate = getKernelRate();
+    lfo.setSampleRate (kernelRate);
+    lfo.reset();
+
+    // In economy mode the resampling filters already delay the wet signal
+    // by one round trip through each 2:1 stage, here in kernel samples.
+    resamplingDelay = 0;
+    for (int factor = 2; factor <= economyFactor; factor *= 2)
+        resamplingDelay += (float) HalfBandResampler<SampleType>::roundTripDelay * (float) (factor / 2) / (float) economyFactor;
+
+    // Read positions are writeHead - jmap(lfo * depth, -1, 1, min, max) * kernelRate
+    delayCentreSamples = 0.5f * (minDelaySeconds + maxDelaySeconds) * (float) kernelRate - resamplingDelay;
+    delaySwingSamples = 0.5f * (maxDelaySeconds - minDelaySeconds) * (float) kernelRate;
+
+    // The interpolated read reaches two samples past the read head, so keep
+    // the chunk two samples shorter than the minimum delay.
+    chunkLength = jlimit (1, maxChunkSize, (int) (kernelRate * minDelaySeconds - resamplingDelay) - 2);
+
+    // Nothing older than the longest delay plus the interpolation neighbours
+    // is ever read back.
+    idleAfterSamples = (int) std::ceil (delayCentreSamples + delaySwingSamples) + 2;
+
+    clear();
+}
+
+template <typename SampleType>
+void ChorusState<SampleType>::clear()
+{
+    for (auto* stage : oversamplers)
+        stage->reset();
+
+    for (auto& stage : economyStages)
+        stage.reset();
+
+    for (int ch = 0; ch < capacityChannels; ch++)
+    {
+        if (storage == DelayStorage::half)
+            compactLines.getUnchecked (ch)->reset();
+        else
+            delayLines.getUnchecked (ch)->reset();
+
+        feedback[ch] = 0;
+        writePeaks[ch] = 0;
+        wetPeaks[ch] = 0;
+    }
+
+    zeromem (interpolatorState, sizeof (interpolatorState));
+    quietSamples = idleAfterSamples;
+}
+
+template <typename SampleType>
+void ChorusState<SampleType>::setQuality (DelayInterpolation::Quality newQuality)
+{
+    if (newQuality == quality)
+        return;
+
+    quality = newQuality;
+
+    // The allpass carries its filters' last outputs forward; don't let it pick up
+    // whatever was left from an earlier run in allpass mode.
+    zeromem (interpolatorState, sizeof (interpolatorState));
+
+    chunkKernel = storage == DelayStorage::half ? getChunkKernel<uint16> (quality)
+                                                : getChunkKernel<SampleType> (quality);
+}
+
+template <typename SampleType>
+template <typename StorageType>
+typename ChorusState<SampleType>::ChunkKernel ChorusState<SampleType>::getChunkKernel (DelayInterpolation::Quality q)
+{
+    switch (q)
+    {
+        case DelayInterpolation::Quality::hermite:   return &ChorusState::processChannelChunk<DelayInterpolation::Hermite, StorageType>;
+        case DelayInterpolation::Quality::lagrange:  return &ChorusState::processChannelChunk<DelayInterpolation::Lagrange, StorageType>;
+        case DelayInterpolation::Quality::allpass:   return &ChorusState::processChannelChunk<DelayInterpolation::Allpass, StorageType>;
+        case DelayInterpolation::Quality::linear:
+        default:                                     return &ChorusState::processChannelChunk<DelayInterpolation::Linear, StorageType>;
+    }
+}
+
+template <typename SampleType>
+void ChorusState<SampleType>::setOversampling (int factor)
+{
+    factor = jlimit (1, getMaxOversamplingFactor(), nextPowerOfTwo (factor));
+
+    if (factor == oversamplingFactor)
+        return;
+
+    oversamplingFactor = factor;
+    oversampler = factor > 1 ? oversamplers[roundToInt (std::log2 (factor)) - 1] : nullptr;
+    configure (sampleRate);
+}
+
+template <typename SampleType>
+int ChorusState<SampleType>::getMaxOversamplingFactor() const
+{
+    auto factor = capacityOversampling;
+
+    while (factor > 1 && ! linesCanHold (sampleRate * factor))
+        factor /= 2;
+
+    return factor;
+}
+
+template <typename SampleType>
+void ChorusState<SampleType>::setEconomyFactor (int factor)
+{
+    factor = jlimit (1, maxEconomyFactor, nextPowerOfTwo (factor));
+
+    if (factor == economyFactor)
+        return;
+
+    economyFactor = factor;
+    configure (sampleRate);
+}
+
+template <typename SampleType>
+int ChorusState<SampleType>::getLatencySamples() const
+{
+    return oversampler != nullptr ? roundToInt (oversampler->getLatencyInSamples()) : 0;
+}
+
+template <typename SampleType>
+dsp::AudioBlock<SampleType> ChorusState<SampleType>::upsample (const dsp::AudioBlock<SampleType>& block)
+{
+    jassert ((int) block.getNumSamples() <= capacityBlockSize);
+
+    if (oversampler == nullptr)
+        return block;
+
+    return oversampler->processSamplesUp (block);
+}
+
+template <typename SampleType>
+void ChorusState<SampleType>::downsample (dsp::AudioBlock<SampleType>& block)
+{
+    if (oversampler != nullptr)
+        oversampler->processSamplesDown (block);
+}
+
+template <typename SampleType>
+dsp::AudioBlock<SampleType> ChorusState<SampleType>::decimate (const dsp::AudioBlock<SampleType>& block)
+{
+    jassert ((int) block.getNumSamples() <= capacityBlockSize);
+
+    numEconomyChannels = jmin ((int) block.getNumChannels(), capacityChannels);
+
+    const SampleType* input[maxChannels];
+    for (int ch = 0; ch < numEconomyChannels; ch++)
+        input[ch] = block.getChannelPointer ((size_t) ch);
+
+    auto* reduced = economyChannels[0];
+    auto numSamples = economyStages[0].decimate (input, reduced, numEconomyChannels, (int) block.getNumSamples());
+
+    if (economyFactor == 4)
+        numSamples = economyStages[1].decimate (reduced, reduced, numEconomyChannels, numSamples);
+
+    return dsp::AudioBlock<SampleType> (reduced, (size_t) numEconomyChannels, (size_t) numSamples);
+}
+
+template <typename SampleType>
+dsp::AudioBlock<SampleType> ChorusState<SampleType>::interpolate (int numSamples)
+{
+    // At 1/4 rate the half-rate signal goes in the second buffer and the
+    // host-rate one back in the first, which has been read by then.
+    auto* reduced = economyChannels[0];
+    auto* wet = economyChannels[1];
+
+    if (economyFactor == 4)
+    {
+        economyStages[1].interpolate (reduced, wet, numEconomyChannels, economyStages[0].getInterpolatorInputLength (numSamples));
+        std::swap (reduced, wet);
+    }
+
+    economyStages[0].interpolate (reduced, wet, numEconomyChannels, numSamples);
+    return dsp::AudioBlock<SampleType> (wet, (size_t) numEconomyChannels, (size_t) numSamples);
+}
+
+//==============================================================================
+template <typename SampleType>
+void ChorusState<SampleType>::updateVoiceLayout (int newNumVoices, float spread)
+{
+    numVoices = jlimit (1, maxVoices, newNumVoices);
+
+    for (int v = 0; v < numVoices; v++)
+    {
+        // -1 for the first voice to +1 for the last.
+        const float position = numVoices > 1 ? 2.0f * (float) v / (float) (numVoices - 1) - 1.0f : 0.0f;
+
+        // Rates fan out by up to +/-25%, and for stereo the voices also pan
+        // across the field. Other layouts weight every voice equally.
+        voiceRates[v] = 1.0f + 0.25f * spread * position;
+        const float pan = spread * position;
+
+        for (int ch = 0; ch < numActiveChannels; ch++)
+        {
+            if (numActiveChannels == 2)
+                voiceGains[ch][v] = ch == 0 ? 1.0f - jmax (0.0f, pan) : 1.0f + jmin (0.0f, pan);
+            else
+                voiceGains[ch][v] = 1.0f;
+        }
+    }
+
+    // Each channel's wet signal is a weighted average of its voices, which
+    // keeps the feedback loop gain below one whatever the voice count.
+    for (int ch = 0; ch < numActiveChannels; ch++)
+    {
+        float total = 0;
+        for (int v = 0; v < numVoices; v++)
+            total += voiceGains[ch][v];
+
+        for (int v = 0; v < numVoices; v++)
+            voiceGains[ch][v] /= total;
+    }
+}
+
+template <typename SampleType>
+void ChorusState<SampleType>::process (SampleType* const* channels, int numChannels, int numSamples,
+                                       const ChorusParameters& params, ChannelWorkerPool* workers)
+{
+    jassert (numSamples <= ChorusParameterRamps::maxBlockSize);
+
+    numActiveChannels = jmin (numChannels, capacityChannels);
+    updateVoiceLayout (params.numVoices, params.voiceSpread);
+
+    lfo.setRate (params.rate, numVoices, voiceRates);
+    lfo.setShape (params.shape);
+    setQuality (params.quality);
+
+    const float offsetStep = numActiveChannels > 1 ? params.phaseOffset * 2.0f / (float) numActiveChannels : 0.0f;
+    for (int ch = 0; ch < numActiveChannels; ch++)
+    {
+        const float offset = offsetStep * (float) ch;
+        channelPhaseOffsets[ch] = offset - std::floor (offset);
+    }
+
+    const bool useWorkers = workers != nullptr && workers->getNumWorkers() < capacityConcurrency;
+
+    currentChannels = channels;
+    currentParams = &params;
+
+    for (int blockStart = 0; blockStart < numSamples; blockStart += lfo.getMaxBlockSize())
+    {
+        currentBlockStart = blockStart;
+        currentBlockLength = jmin (lfo.getMaxBlockSize(), numSamples - blockStart);
+        lfo.process (currentBlockLength, channelPhaseOffsets, numActiveChannels);
+
+        if (useWorkers)
+            workers->run (*this, numActiveChannels);
+        else
+            for (int ch = 0; ch < numActiveChannels; ch++)
+                runTask (ch, 0);
+    }
+
+    // Everything written to the lines (input plus feedback) has to stay
+    // below the threshold for a whole delay-line length before the state
+    // counts as idle; at that point it is cleared once so nothing stale is
+    // left when the input comes back.
+    float peak = 0;
+    wetPeak = 0;
+    for (int ch = 0; ch < numActiveChannels; ch++)
+    {
+        peak = jmax (peak, writePeaks[ch]);
+        wetPeak = jmax (wetPeak, wetPeaks[ch]);
+        writePeaks[ch] = 0;
+        wetPeaks[ch] = 0;
+    }
+
+    lastDepth = params.depth[numSamples - 1];
+
+    if (peak > silenceThreshold)
+    {
+        quietSamples = 0;
+    }
+    else if (! isIdle())
+    {
+        quietSamples += numSamples;
+
+        if (isIdle())
+            clear();
+    }
+}
+
+template <typename SampleType>
+void ChorusState<SampleType>::runTask (int channel, int workerSlot)
+{
+    auto* channelData = currentChannels[channel] + currentBlockStart;
+
+    for (int start = 0; start < currentBlockLength; start += chunkLength)
+    {
+        const int chunkSamples = jmin (chunkLength, currentBlockLength - start);
+        (this->*chunkKernel) (channelData + start, channel, start, chunkSamples, *currentParams, scratch[workerSlot]);
+    }
+}
+
+template <typename SampleType>
+template <typename Interpolator, typename StorageType>
+void ChorusState<SampleType>::processChannelChunk (SampleType* channelData, int channel, int blockOffset, int numSamples,
+                                                   const ChorusParameters& params, ChunkScratch& s)
+{
+    auto& delayLine = getDelayLine<StorageType> (channel);
+    const float readOrigin = delayLine.getReadOrigin() - delayCentreSamples;
+
+    const auto* mix = toSampleType (params.mix + currentBlockStart + blockOffset, s.mix, numSamples);
+    const auto* fBack = toSampleType (params.feedback + currentBlockStart + blockOffset, s.feedback, numSamples);
+    FloatVectorOperations::copyWithMultiply (s.swing, params.depth + currentBlockStart + blockOffset, -delaySwingSamples, numSamples);
+
+    if constexpr (hasVoiceLanes)
+    {
+        if (numVoices > 4)
+            readVoiceLanes<Interpolator, StorageType, 2> (delayLine, readOrigin, channel, blockOffset, numSamples, s);
+        else if (numVoices >= minLaneVoices)
+            readVoiceLanes<Interpolator, StorageType, 1> (delayLine, readOrigin, channel, blockOffset, numSamples, s);
+        else
+            readEachVoice<Interpolator, StorageType> (delayLine, readOrigin, channel, blockOffset, numSamples, s);
+    }
+    else
+    {
+        readEachVoice<Interpolator, StorageType> (delayLine, readOrigin, channel, blockOffset, numSamples, s);
+    }
+
+    // Each written sample carries the feedback from the previous sample's
+    // read, so the feedback signal is the wet chunk delayed by one.
+    auto* writeData = s.tap[0];
+    writeData[0] = feedback[channel];
+    FloatVectorOperations::multiply (writeData + 1, s.wet, fBack, numSamples - 1);
+    FloatVectorOperations::add (writeData, channelData, numSamples);
+    feedback[channel] = fBack[numSamples - 1] * s.wet[numSamples - 1];
+    delayLine.push (writeData, numSamples);
+
+    const auto writeRange = FloatVectorOperations::findMinAndMax (writeData, numSamples);
+    writePeaks[channel] = jmax (writePeaks[channel], (float) writeRange.getEnd(), (float) -writeRange.getStart());
+
+    const auto wetRange = FloatVectorOperations::findMinAndMax (s.wet, numSamples);
+    wetPeaks[channel] = jmax (wetPeaks[channel], (float) wetRange.getEnd(), (float) -wetRange.getStart());
+
+    // out = in + mix * (wet - in)
+    FloatVectorOperations::subtract (s.tap[1], s.wet, channelData, numSamples);
+    FloatVectorOperations::addWithMultiply (channelData, s.tap[1], mix, numSamples);
+}
+
+template <typename SampleType>
+template <typename Interpolator, typename StorageType>
+void ChorusState<SampleType>::readEachVoice (const ModulatedDelayLine<SampleType, StorageType>& delayLine, float readOrigin,
+                                             int channel, int blockOffset, int numSamples, ChunkScratch& s)
+{
+    FloatVectorOperations::clear (s.wet, numSamples);
+
+    for (int v = 0; v < numVoices; v++)
+    {
+        FloatVectorOperations::add (s.readPos, rampChunk, readOrigin, numSamples);
+        FloatVectorOperations::addWithMultiply (s.readPos, lfo.getOutput (v, channel) + blockOffset, s.swing, numSamples);
+
+        // The interpolated read is the only part of the chunk that can't be
+        // expressed as a vector operation.
+        delayLine.template read<Interpolator> (s.readPos, s.tap[1], numSamples, interpolatorState[channel][v]);
+        FloatVectorOperations::addWithMultiply (s.wet, s.tap[1], (SampleType) voiceGains[channel][v], numSamples);
+    }
+}
+
+template <typename SampleType>
+template <typename Interpolator, typename StorageType, int numGroups>
+void ChorusState<SampleType>::readVoiceLanes (const ModulatedDelayLine<SampleType, StorageType>& delayLine, float readOrigin,
+                                              int channel, int blockOffset, int numSamples, ChunkScratch& s)
+{
+   #if EZ_CHORUS_VOICE_LANES
+    static_assert (std::is_same_v<SampleType, float>, "The lanes hold four floats");
+    constexpr int numLanes = 4 * numGroups;
+    static_assert (numLanes <= maxVoices, "Each lane needs a voice's interpolator state");
+
+    const float* lfoOutputs[numLanes];
+    alignas (16) float gains[numLanes];
+    alignas (16) float lowerPair[numLanes], upperPair[numLanes], lastFrac[numLanes];
+
+    for (int v = 0; v < numLanes; v++)
+    {
+        lfoOutputs[v] = lfo.getOutput (v < numVoices ? v : 0, channel) + blockOffset;
+        gains[v] = v < numVoices ? voiceGains[channel][v] : 0.0f;
+        lowerPair[v] = interpolatorState[channel][v].lowerPair;
+        upperPair[v] = interpolatorState[channel][v].upperPair;
+        lastFrac[v] = interpolatorState[channel][v].lastFrac;
+    }
+
+    __m128 groupGains[numGroups];
+    DelayInterpolation::LaneState groupState[numGroups];
+
+    for (int g = 0; g < numGroups; g++)
+    {
+        groupGains[g] = _mm_load_ps (gains + 4 * g);
+        groupState[g] = { _mm_load_ps (lowerPair + 4 * g), _mm_load_ps (upperPair + 4 * g), _mm_load_ps (lastFrac + 4 * g) };
+    }
+
+    const auto* data = delayLine.getData();
+    const auto mask = _mm_set1_epi32 (delayLine.getMask());
+
+    // Each lane's four neighbours are contiguous, so they load as one vector
+    // and a 4x4 transpose turns them into x[-1]..x[2] across the lanes.
+    const auto loadNeighbours = [data] (int start)
+    {
+        if constexpr (std::is_same_v<StorageType, uint16>)
+        {
+            float neighbours[4];
+            HalfFloat::unpack4 (neighbours, data + start);
+            return _mm_loadu_ps (neighbours);
+        }
+        else
+        {
+            return _mm_loadu_ps (data + start);
+        }
+    };
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        const auto origin = _mm_set1_ps (readOrigin + rampChunk[i]);
+        const auto swing = _mm_set1_ps (s.swing[i]);
+        auto wet = _mm_setzero_ps();
+
+        for (int g = 0; g < numGroups; g++)
+        {
+            const auto* lanes = lfoOutputs + 4 * g;
+            const auto modulation = _mm_setr_ps (lanes[0][i], lanes[1][i], lanes[2][i], lanes[3][i]);
+            const auto position = _mm_add_ps (origin, _mm_mul_ps (modulation, swing));
+            const auto index = _mm_cvttps_epi32 (position);
+            const auto frac = _mm_sub_ps (position, _mm_cvtepi32_ps (index));
+
+            alignas (16) int32 starts[4];
+            _mm_store_si128 ((__m128i*) starts, _mm_and_si128 (_mm_sub_epi32 (index, _mm_set1_epi32 (1)), mask));
+
+            __m128 p[4] = { loadNeighbours (starts[0]), loadNeighbours (starts[1]),
+                            loadNeighbours (starts[2]), loadNeighbours (starts[3]) };
+            _MM_TRANSPOSE4_PS (p[0], p[1], p[2], p[3]);
+
+            wet = _mm_add_ps (wet, _mm_mul_ps (groupGains[g], Interpolator::interpolate4 (p, frac, groupState[g])));
+        }
+
+        wet = _mm_add_ps (wet, _mm_movehl_ps (wet, wet));
+        wet = _mm_add_ss (wet, _mm_shuffle_ps (wet, wet, 1));
+        s.wet[i] = _mm_cvtss_f32 (wet);
+    }
+
+    for (int g = 0; g < numGroups; g++)
+    {
+        _mm_store_ps (lowerPair + 4 * g, groupState[g].lowerPair);
+        _mm_store_ps (upperPair + 4 * g, groupState[g].upperPair);
+        _mm_store_ps (lastFrac + 4 * g, groupState[g].lastFrac);
+    }
+
+    for (int v = 0; v < numVoices; v++)
+        interpolatorState[channel][v] = { lowerPair[v], upperPair[v], lastFrac[v] };
+   #else
+    ignoreUnused (delayLine, readOrigin, channel, blockOffset, numSamples, s);
+    jassertfalse;
+   #endif
+}
+
+template <typename SampleType>
+void ChorusState<SampleType>::fillTelemetry (ChorusTelemetry::Frame& frame) const
+{
+    frame.numChannels = jmin (numActiveChannels, ChorusTelemetry::maxChannels);
+
+    const auto last = jmax (0, currentBlockLength - 1);
+    const auto msPerSample = 1000.0f / (float) getKernelRate();
+
+    for (int ch = 0; ch < frame.numChannels; ch++)
+    {
+        const auto lfoValue = lfo.getOutput (0, ch)[last];
+        frame.lfo[ch] = lfoValue;
+        frame.delayMs[ch] = (delayCentreSamples + resamplingDelay + lfoValue * lastDepth * delaySwingSamples) * msPerSample;
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+ChorusStateSwap<SampleType>::~ChorusStateSwap()
+{
+    collectGarbage();
+    delete pending.exchange (nullptr);
+    delete active;
+}
+
+template <typename SampleType>
+void ChorusStateSwap<SampleType>::prepare (double sampleRate, int maxBlockSize, int numChannels, int maxConcurrency,
+                                          int maxOversampling, DelayStorage storage)
+{
+    collectGarbage();
+
+    requestedSampleRate.store (sampleRate);
+    const auto newGeneration = ++generation;
+
+    if (newest != nullptr && newest->getDelayStorage() == storage
+         && newest->canRunAt (sampleRate, maxBlockSize, numChannels, maxConcurrency, maxOversampling))
+        return; // acquire() will retune the existing state in place
+
+    auto* state = new State (sampleRate, maxBlockSize, numChannels, maxConcurrency, maxOversampling, storage);
+    state->generation = newGeneration;
+    newest = state;
+
+    // A state that was published but never picked up can be freed straight away.
+    delete pending.exchange (state, std::memory_order_acq_rel);
+}
+
+template <typename SampleType>
+void ChorusStateSwap<SampleType>::collectGarbage()
+{
+    for (auto& slot : retired)
+        delete slot.exchange (nullptr, std::memory_order_acquire);
+}
+
+template <typename SampleType>
+ChorusState<SampleType>* ChorusStateSwap<SampleType>::acquire()
+{
+    if (pending.load (std::memory_order_relaxed) != nullptr)
+    {
+        // Only swap if there is somewhere to park the old state; otherwise
+        // keep using it until the message thread has collected garbage.
+        for (auto& slot : retired)
+        {
+            if (slot.load (std::memory_order_relaxed) == nullptr)
+            {
+                if (auto* next = pending.exchange (nullptr, std::memory_order_acq_rel))
+                {
+                    slot.store (active, std::memory_order_release);
+                    active = next;
+                }
+                break;
+            }
+        }
+    }
+
+    if (active != nullptr)
+    {
+        const auto currentGeneration = generation.load (std::memory_order_acquire);
+        if (active->generation != currentGeneration)
+        {
+            // If the retune needs a bigger state that couldn't be swapped in
+            // yet, keep the current settings and try again next block.
+            const auto sampleRate = requestedSampleRate.load();
+            if (active->canRunAt (sampleRate, 0, 0, 0))
+            {
+                active->configure (sampleRate);
+                active->generation = currentGeneration;
+            }
+        }
+    }
+
+    return active;
+}
+
+//==============================================================================
+template class ChorusState<float>;
+template class ChorusState<double>;
+template class ChorusStateSwap<float>;
+template class ChorusStateSwap<double>;
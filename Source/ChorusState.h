@@ -0,0 +1,372 @@
+/*
+  ==============================================================================
+
+    ChorusState.h
+    All of the chorus DSP state for one sample-rate/block-size configuration,
+    and the lock-free handoff that swaps it in on the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChorusLFO.h"
+#include "ChorusParameters.h"
+#include "ModulatedDelayLine.h"
+#include "ChannelWorkerPool.h"
+#include "ChorusTelemetry.h"
+#include "HalfBandResampler.h"
+
+using namespace juce;
+
+//==============================================================================
+/**
+    The limits and timing constants shared by both sample types of
+    ChorusState.
+*/
+struct ChorusStateBase
+{
+    static constexpr int maxChannels = 16;
+    static constexpr int maxOversamplingFactor = 4;
+    static constexpr int maxEconomyFactor = 4;
+
+    /** Signals below this peak level (-100 dB) count as silence. */
+    static constexpr float silenceThreshold = 1.0e-5f;
+
+    /** The most noise, in dB RMS relative to the output, that half-float
+        delay lines may add. A round trip measures -74 dB, and the feedback
+        loop raises the wet signal's floor to -64 dB at the maximum feedback
+        of 0.98. This leaves margin over that for many voices and for
+        oversampling. The tools check DelayStorage::half against it.
+    */
+    static constexpr double halfStorageNoiseDb = -52.0;
+
+    /** How long the feedback loop takes to ring down to silenceThreshold. */
+    static double getTailLengthSeconds (float feedbackGain);
+
+    /** Message thread: the delay, in host samples, that the oversampling
+        filters add at this factor.
+    */
+    static int getOversamplingLatency (int factor);
+
+protected:
+    // Audio is processed in chunks no longer than the shortest possible
+    // modulated delay, so every read in a chunk only touches samples written
+    // before it and the whole chunk can be computed with vector operations.
+    static constexpr int maxChunkSize = 256;
+    static constexpr float minDelaySeconds = 0.005f;
+    static constexpr float maxDelaySeconds = 0.03f;
+
+    static constexpr int maxVoices = ChorusLFO::maxVoices;
+
+    static int maxDelaySamplesFor (double rate);
+};
+
+//==============================================================================
+/**
+    Delay lines, LFO and scratch space sized for a given capacity.
+
+    The constructor allocates; configure() and process() never do, so a state
+    can be retuned in place on the audio thread for any sample rate, block
+    size and channel count that fit within what it was built for.
+
+    The kernel can run at 2x or 4x the host rate. The delay lines and the
+    half-band polyphase oversampling filters are only built for the factors
+    up to the one the state is built for, so switching between those never
+    allocates either, though it does clear the delay lines. A state asked
+    for more settles for the highest factor it can run, and a bigger one
+    has to be built on the message thread.
+
+    In economy mode it runs at 1/2 or 1/4 of the host rate instead, on a
+    decimated copy of the input. Only the wet signal is interpolated back
+    up, and the dry signal is mixed in at the host rate. The filters' delay
+    is taken off the modulated delay, so the wet signal lines up with
+    full-rate processing and no latency is added. The feedback loop runs
+    entirely at the reduced rate, so its delay ends up that much shorter.
+
+    Every channel has its own delay line and LFO tap; the taps are spread
+    around the cycle by the phase offset, so for stereo the right channel
+    sits PHASEOFFSET cycles ahead of the left and at an offset of 0.5 any
+    channel count ends up evenly distributed.
+
+    SampleType (float or double) is the type of the audio, the delay lines
+    and the feedback path. The LFO, read positions and parameter ramps stay
+    in float for both. The delay lines can instead store half floats, chosen
+    when the state is built, to cut their memory and cache footprint.
+*/
+template <typename SampleType>
+class ChorusState  : public ChorusStateBase,
+                     private ChannelWorkerPool::Task
+{
+public:
+    /** maxConcurrency is the number of threads that may process channels of
+        the same block at once (1 unless a ChannelWorkerPool is used).
+        maxOversampling (1, 2 or 4) is the highest oversampling factor the
+        state can switch to.
+    */
+    ChorusState (double sampleRate, int maxBlockSize, int numChannels, int maxConcurrency,
+                 int maxOversampling = 1, DelayStorage storage = DelayStorage::full);
+
+    /** True if configure() can switch to these settings without reallocating,
+        and setOversampling() can then go up to the given factor.
+    */
+    bool canRunAt (double sampleRate, int blockSize, int numChannels, int concurrency, int oversampling = 1) const;
+
+    DelayStorage getDelayStorage() const    { return storage; }
+
+    /** Bytes held by the delay lines. */
+    size_t getDelayMemoryBytes() const;
+
+    /** Recomputes the rate-dependent constants and clears the state. */
+    void configure (double sampleRate);
+
+    /** Runs the kernel at sampleRate * factor (1, 2 or 4) from now on, or at
+        getMaxOversamplingFactor() if that is lower. Reconfigures and clears
+        the state if the factor changes.
+    */
+    void setOversampling (int factor);
+
+    /** The highest factor setOversampling() can use at the current sample rate. */
+    int getMaxOversamplingFactor() const;
+
+    /** Runs the kernel at sampleRate / factor (1, 2 or 4) from now on; use
+        decimate() and interpolate() rather than upsample() and downsample()
+        while it is above 1. It is meant to be used with an oversampling
+        factor of 1. Reconfigures and clears the state if the factor changes.
+    */
+    void setEconomyFactor (int factor);
+
+    /** Clears the delay lines, feedback and resampling filters. */
+    void reset()                        { clear(); }
+
+    /** Returns the block to pass to process(): the input itself, or its
+        upsampled copy in the state's own buffers. The block must be no longer
+        than the block size the state was built for.
+    */
+    dsp::AudioBlock<SampleType> upsample (const dsp::AudioBlock<SampleType>& block);
+
+    /** Writes the processed upsampled signal back into block. */
+    void downsample (dsp::AudioBlock<SampleType>& block);
+
+    /** Economy mode: returns a copy of block at the kernel rate, in the
+        state's own buffers, for process() to turn into the wet signal.
+    */
+    dsp::AudioBlock<SampleType> decimate (const dsp::AudioBlock<SampleType>& block);
+
+    /** Economy mode: interpolates the block returned by the last decimate()
+        back up to numSamples samples at the host rate, where numSamples is
+        the length of the block that was decimated.
+    */
+    dsp::AudioBlock<SampleType> interpolate (int numSamples);
+
+    /** Processes numChannels (up to the capacity) in place at the kernel rate.
+        numSamples must not exceed the length of the parameter ramps. If a
+        worker pool is passed, the channels are shared out across its threads.
+    */
+    void process (SampleType* const* channels, int numChannels, int numSamples,
+                  const ChorusParameters& params, ChannelWorkerPool* workers = nullptr);
+
+    /** True once everything the delay lines could still play back has decayed
+        below silenceThreshold. The lines have been cleared, so while the
+        input stays silent process() can be skipped altogether.
+    */
+    bool isIdle() const                 { return quietSamples >= idleAfterSamples; }
+
+    /** Peak level of the wet signal over the last process() call. */
+    float getWetPeak() const            { return wetPeak; }
+
+    /** Writes each channel's LFO position and delay at the end of the last
+        process() call into frame.
+    */
+    void fillTelemetry (ChorusTelemetry::Frame& frame) const;
+
+    double getSampleRate() const        { return sampleRate; }
+    int getMaxBlockSize() const         { return capacityBlockSize; }
+    int getOversamplingFactor() const   { return oversamplingFactor; }
+    int getEconomyFactor() const        { return economyFactor; }
+    double getKernelRate() const        { return sampleRate * oversamplingFactor / economyFactor; }
+
+    /** The delay, in host samples, that the current oversampling factor adds. */
+    int getLatencySamples() const;
+
+    /** Set by ChorusStateSwap to track which prepareToPlay this state reflects. */
+    uint32 generation = 0;
+
+private:
+    struct ChunkScratch
+    {
+        float readPos[maxChunkSize];
+        float swing[maxChunkSize];
+        SampleType tap[2][maxChunkSize];
+        SampleType wet[maxChunkSize];
+        SampleType mix[maxChunkSize];        // the float ramps, converted for the double kernel
+        SampleType feedback[maxChunkSize];
+    };
+
+    // One instantiation of the chunk kernel per interpolation quality and
+    // storage type; the block picks one up front so the inner loops never
+    // test either.
+    using ChunkKernel = void (ChorusState::*) (SampleType*, int, int, int, const ChorusParameters&, ChunkScratch&);
+
+    /** The parameter ramps are float; the double kernel works on a converted
+        copy in dest, the float kernel on the ramp itself.
+    */
+    static const SampleType* toSampleType (const float* source, SampleType* dest, int numSamples)
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            ignoreUnused (dest, numSamples);
+            return source;
+        }
+        else
+        {
+            for (int i = 0; i < numSamples; i++)
+                dest[i] = (SampleType) source[i];
+
+            return dest;
+        }
+    }
+
+    void clear();
+    void updateVoiceLayout (int numVoices, float spread);
+    void setQuality (DelayInterpolation::Quality newQuality);
+    void runTask (int channel, int workerSlot) override;
+
+    template <typename StorageType>
+    static ChunkKernel getChunkKernel (DelayInterpolation::Quality quality);
+
+    template <typename StorageType>
+    ModulatedDelayLine<SampleType, StorageType>& getDelayLine (int channel)
+    {
+        if constexpr (std::is_same_v<StorageType, uint16>)
+            return *compactLines.getUnchecked (channel);
+        else
+            return *delayLines.getUnchecked (channel);
+    }
+
+    /** True if the delay lines are long enough to run the kernel at this rate. */
+    bool linesCanHold (double kernelRate) const;
+
+    template <typename Interpolator, typename StorageType>
+    void processChannelChunk (SampleType* channelData, int channel, int blockOffset, int numSamples,
+                              const ChorusParameters& params, ChunkScratch& scratch);
+
+    /** Sums every voice's tap into scratch.wet, one voice at a time along
+        the chunk.
+    */
+    template <typename Interpolator, typename StorageType>
+    void readEachVoice (const ModulatedDelayLine<SampleType, StorageType>& delayLine, float readOrigin, int channel,
+                        int blockOffset, int numSamples, ChunkScratch& scratch);
+
+    /** The same sum with the voices side by side in numGroups groups of four
+        float lanes, one sample at a time. Lanes past numVoices repeat voice 0
+        with a gain of 0. Only float states on SSE2 builds use it.
+    */
+    template <typename Interpolator, typename StorageType, int numGroups>
+    void readVoiceLanes (const ModulatedDelayLine<SampleType, StorageType>& delayLine, float readOrigin, int channel,
+                         int blockOffset, int numSamples, ChunkScratch& scratch);
+
+    // Below this many voices the per-voice loop is faster than the lanes.
+    static constexpr int minLaneVoices = 4;
+    static constexpr bool hasVoiceLanes = EZ_CHORUS_VOICE_LANES && std::is_same_v<SampleType, float>;
+
+    const int capacityBlockSize;
+    const int capacityChannels;
+    const int capacityConcurrency;
+    const int capacityOversampling;
+    const DelayStorage storage;
+
+    double sampleRate = 0;
+    int oversamplingFactor = 1;
+    int economyFactor = 1;
+    int chunkLength = 1;
+    float delayCentreSamples = 0;
+    float delaySwingSamples = 0;
+    float resamplingDelay = 0;
+    int idleAfterSamples = 0;
+    int quietSamples = 0;
+    float wetPeak = 0;
+    float lastDepth = 0;
+
+    ChorusLFO lfo;
+    OwnedArray<dsp::Oversampling<SampleType>> oversamplers;   // 2x, then 4x, up to capacityOversampling
+    dsp::Oversampling<SampleType>* oversampler = nullptr;
+    HalfBandResampler<SampleType> economyStages[2];                         // 1/2, then 1/4
+    HeapBlock<SampleType> economyBuffers;
+    SampleType* economyChannels[2][maxChannels] = {};
+    int numEconomyChannels = 0;
+    OwnedArray<ModulatedDelayLine<SampleType>> delayLines;                  // DelayStorage::full
+    OwnedArray<ModulatedDelayLine<SampleType, uint16>> compactLines;        // DelayStorage::half
+    HeapBlock<SampleType> feedback;
+    HeapBlock<float> channelPhaseOffsets;
+    HeapBlock<ChunkScratch> scratch;
+    float rampChunk[maxChunkSize];
+
+    // Per-voice settings, laid out so each voice's values sit side by side.
+    int numActiveChannels = 0;
+    int numVoices = 1;
+    float voiceRates[maxVoices] = {};
+    float voiceGains[maxChannels][maxVoices] = {};
+    DelayInterpolation::State<SampleType> interpolatorState[maxChannels][maxVoices] = {};
+    float writePeaks[maxChannels] = {};   // per channel, so worker threads don't share them
+    float wetPeaks[maxChannels] = {};
+
+    DelayInterpolation::Quality quality = DelayInterpolation::Quality::linear;
+    ChunkKernel chunkKernel = nullptr;
+
+    // The block currently being shared out between worker threads.
+    SampleType* const* currentChannels = nullptr;
+    int currentBlockStart = 0;
+    int currentBlockLength = 0;
+    const ChorusParameters* currentParams = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChorusState)
+};
+
+//==============================================================================
+/**
+    Hands ChorusState objects from prepareToPlay to processBlock.
+
+    prepare() retunes the current state in place when it is big enough, and
+    otherwise builds a new one on the calling thread and publishes it. The
+    audio thread picks up new states and pending retunes in acquire(), which
+    never allocates, frees or locks; states it has finished with are parked
+    in a small retire list and freed by the next prepare() or
+    collectGarbage() call.
+*/
+template <typename SampleType>
+class ChorusStateSwap
+{
+public:
+    ChorusStateSwap() = default;
+    ~ChorusStateSwap();
+
+    /** Message thread. maxOversampling is the highest factor the state
+        must be able to switch to on the audio thread. Changing the storage
+        always builds a new state.
+    */
+    void prepare (double sampleRate, int maxBlockSize, int numChannels, int maxConcurrency = 1,
+                  int maxOversampling = 1, DelayStorage storage = DelayStorage::full);
+
+    /** Message thread: frees states the audio thread has retired. */
+    void collectGarbage();
+
+    /** Audio thread: the state to use for this block, or nullptr before the
+        first prepare().
+    */
+    ChorusState<SampleType>* acquire();
+
+private:
+    using State = ChorusState<SampleType>;
+    static constexpr int maxRetired = 4;
+
+    State* active = nullptr;                            // audio thread only
+    State* newest = nullptr;                            // message thread only
+    std::atomic<State*> pending { nullptr };
+    std::atomic<State*> retired[maxRetired] {};
+    std::atomic<uint32> generation { 0 };
+    std::atomic<double> requestedSampleRate { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChorusStateSwap)
+};
@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+    ChorusTelemetry.cpp
+    Lock-free channel carrying LFO, delay and level readings from the audio
+    thread to the editor.
+
+  ==============================================================================
+*/
+
+#include "ChorusTelemetry.h"
+
+//==============================================================================
+void ChorusTelemetry::prepare (double sampleRate)
+{
+    samplesPerFrame = jmax (1, roundToInt (sampleRate / framesPerSecond));
+}
+
+ChorusTelemetry::Frame* ChorusTelemetry::accumulate (int numSamples, float inputPeak, float outputPeak, float wetPeak)
+{
+    pending.inputPeak = jmax (pending.inputPeak, inputPeak);
+    pending.outputPeak = jmax (pending.outputPeak, outputPeak);
+    pending.wetPeak = jmax (pending.wetPeak, wetPeak);
+    pendingSamples += numSamples;
+
+    return pendingSamples >= samplesPerFrame ? &pending : nullptr;
+}
+
+void ChorusTelemetry::publish()
+{
+    const auto scope = fifo.write (1);
+
+    if (scope.blockSize1 > 0)
+        frames[scope.startIndex1] = pending;
+    else if (scope.blockSize2 > 0)
+        frames[scope.startIndex2] = pending;
+
+    pending.inputPeak = 0;
+    pending.outputPeak = 0;
+    pending.wetPeak = 0;
+    pendingSamples = 0;
+}
+
+int ChorusTelemetry::pull (Frame* dest, int maxFrames)
+{
+    int numRead = 0;
+    const auto scope = fifo.read (jmin (maxFrames, fifo.getNumReady()));
+    scope.forEach ([&] (int index) { dest[numRead++] = frames[index]; });
+    return numRead;
+}
+
+void ChorusTelemetry::notifyIfReady()
+{
+    if (fifo.getNumReady() > 0)
+        sendSynchronousChangeMessage();
+}
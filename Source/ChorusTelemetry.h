@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    ChorusTelemetry.h
+    Lock-free channel carrying LFO, delay and level readings from the audio
+    thread to the editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace juce;
+
+//==============================================================================
+/**
+    A single-producer/single-consumer FIFO of fixed-size frames.
+
+    The audio thread folds every block into a pending frame and publishes it
+    framesPerSecond times a second, so the cost per block is a few comparisons
+    whatever the block size. Publishing never allocates or locks; if the
+    editor is closed or falls behind, new frames are simply dropped.
+
+    A reader can stop polling while nothing is published. notifyIfReady(),
+    called from a timer the owner already runs, tells it when frames
+    arrive again.
+*/
+class ChorusTelemetry  : public ChangeBroadcaster
+{
+public:
+    static constexpr int maxChannels = 16;
+    static constexpr int capacity = 32;
+    static constexpr int framesPerSecond = 30;
+
+    struct Frame
+    {
+        int numChannels = 0;
+        float lfo[maxChannels] = {};        // first voice, -1 to 1
+        float delayMs[maxChannels] = {};    // first voice's modulated delay
+        float inputPeak = 0;
+        float outputPeak = 0;
+        float wetPeak = 0;
+    };
+
+    ChorusTelemetry() = default;
+
+    /** Message thread: sets the publishing interval for this sample rate. */
+    void prepare (double sampleRate);
+
+    /** Audio thread: folds one block's peak levels into the pending frame.
+        Returns the frame once it is due, so the caller can fill in the LFO
+        and delay readings before calling publish(); otherwise nullptr.
+    */
+    Frame* accumulate (int numSamples, float inputPeak, float outputPeak, float wetPeak);
+
+    /** Audio thread: pushes the pending frame and starts a new one. */
+    void publish();
+
+    /** Message thread: moves up to maxFrames of the oldest unread frames into
+        dest and returns how many were read.
+    */
+    int pull (Frame* dest, int maxFrames);
+
+    /** Message thread: sends a synchronous change message if there are
+        unread frames.
+    */
+    void notifyIfReady();
+
+private:
+    AbstractFifo fifo { capacity };
+    Frame frames[capacity];
+
+    Frame pending;
+    int samplesPerFrame = 1;
+    int pendingSamples = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChorusTelemetry)
+};
@@ -0,0 +1,216 @@
+/*
+  ==============================================================================
+
+    DelayInterpolation.h
+    Fractional-delay interpolators for the modulated delay reads.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define EZ_CHORUS_VOICE_LANES 1
+#else
+ #define EZ_CHORUS_VOICE_LANES 0
+#endif
+
+using namespace juce;
+
+//==============================================================================
+/**
+    Each interpolator reads four consecutive delay-line samples
+    p[0..3] = x[-1], x[0], x[1], x[2] around a read position that lies
+    between x[0] and x[1], with frac measured from x[0] towards x[1].
+
+    They are used as template arguments so the kernel is compiled once per
+    quality mode and the inner loop never branches on it. A State carries
+    anything an interpolator needs between samples (only the allpass uses it).
+
+    On SSE2 builds each one also has an interpolate4() that runs the same
+    arithmetic on four float lanes at once, one voice per lane.
+*/
+namespace DelayInterpolation
+{
+    enum class Quality
+    {
+        linear,
+        hermite,
+        lagrange,
+        allpass
+    };
+
+    /** One tap's memory from one sample to the next. */
+    template <typename SampleType>
+    struct State
+    {
+        SampleType lowerPair {}, upperPair {}, lastFrac {};
+    };
+
+   #if EZ_CHORUS_VOICE_LANES
+    /** A State for four voices' taps, one per lane. */
+    struct LaneState
+    {
+        __m128 lowerPair, upperPair, lastFrac;
+    };
+   #endif
+
+    struct Linear
+    {
+        template <typename SampleType>
+        static SampleType interpolate (const SampleType* p, SampleType frac, State<SampleType>&)
+        {
+            return p[1] + frac * (p[2] - p[1]);
+        }
+
+       #if EZ_CHORUS_VOICE_LANES
+        static __m128 interpolate4 (const __m128* p, __m128 frac, LaneState&)
+        {
+            return _mm_add_ps (p[1], _mm_mul_ps (frac, _mm_sub_ps (p[2], p[1])));
+        }
+       #endif
+    };
+
+    /** 4-point, 3rd-order Hermite (Catmull-Rom). */
+    struct Hermite
+    {
+        template <typename SampleType>
+        static SampleType interpolate (const SampleType* p, SampleType frac, State<SampleType>&)
+        {
+            const auto c1 = (SampleType) 0.5 * (p[2] - p[0]);
+            const auto c2 = p[0] - (SampleType) 2.5 * p[1] + (SampleType) 2 * p[2] - (SampleType) 0.5 * p[3];
+            const auto c3 = (SampleType) 0.5 * (p[3] - p[0]) + (SampleType) 1.5 * (p[1] - p[2]);
+            return ((c3 * frac + c2) * frac + c1) * frac + p[1];
+        }
+
+       #if EZ_CHORUS_VOICE_LANES
+        static __m128 interpolate4 (const __m128* p, __m128 frac, LaneState&)
+        {
+            const auto half = _mm_set1_ps (0.5f);
+            const auto c1 = _mm_mul_ps (half, _mm_sub_ps (p[2], p[0]));
+            const auto c2 = _mm_sub_ps (_mm_add_ps (_mm_sub_ps (p[0], _mm_mul_ps (_mm_set1_ps (2.5f), p[1])),
+                                                    _mm_mul_ps (_mm_set1_ps (2.0f), p[2])),
+                                        _mm_mul_ps (half, p[3]));
+            const auto c3 = _mm_add_ps (_mm_mul_ps (half, _mm_sub_ps (p[3], p[0])),
+                                        _mm_mul_ps (_mm_set1_ps (1.5f), _mm_sub_ps (p[1], p[2])));
+            return _mm_add_ps (_mm_mul_ps (_mm_add_ps (_mm_mul_ps (_mm_add_ps (_mm_mul_ps (c3, frac), c2), frac), c1), frac), p[1]);
+        }
+       #endif
+    };
+
+    /** 4-point, 3rd-order Lagrange through x[-1]..x[2]. */
+    struct Lagrange
+    {
+        template <typename SampleType>
+        static SampleType interpolate (const SampleType* p, SampleType frac, State<SampleType>&)
+        {
+            const auto d0 = frac + (SampleType) 1;
+            const auto d2 = frac - (SampleType) 1;
+            const auto d3 = frac - (SampleType) 2;
+
+            return - p[0] * frac * d2 * d3 / (SampleType) 6
+                   + p[1] * d0 * d2 * d3 / (SampleType) 2
+                   - p[2] * d0 * frac * d3 / (SampleType) 2
+                   + p[3] * d0 * frac * d2 / (SampleType) 6;
+        }
+
+       #if EZ_CHORUS_VOICE_LANES
+        static __m128 interpolate4 (const __m128* p, __m128 frac, LaneState&)
+        {
+            const auto one = _mm_set1_ps (1.0f);
+            const auto six = _mm_set1_ps (6.0f);
+            const auto two = _mm_set1_ps (2.0f);
+            const auto d0 = _mm_add_ps (frac, one);
+            const auto d2 = _mm_sub_ps (frac, one);
+            const auto d3 = _mm_sub_ps (frac, two);
+
+            auto y = _mm_sub_ps (_mm_setzero_ps(), _mm_div_ps (_mm_mul_ps (_mm_mul_ps (_mm_mul_ps (p[0], frac), d2), d3), six));
+            y = _mm_add_ps (y, _mm_div_ps (_mm_mul_ps (_mm_mul_ps (_mm_mul_ps (p[1], d0), d2), d3), two));
+            y = _mm_sub_ps (y, _mm_div_ps (_mm_mul_ps (_mm_mul_ps (_mm_mul_ps (p[2], d0), frac), d3), two));
+            return _mm_add_ps (y, _mm_div_ps (_mm_mul_ps (_mm_mul_ps (_mm_mul_ps (p[3], d0), frac), d2), six));
+        }
+       #endif
+    };
+
+    /** First-order allpass. Flat magnitude response, so it doesn't dull the
+        highs, at the cost of some phase error on fast modulation.
+
+        Two filters run side by side, one on the pair x[0], x[1] and one on
+        x[1], x[2], and are crossfaded by frac: all lower pair at 0, all
+        upper pair from crossfadeEnd up. Neither filter changes pairs while
+        it is heard, so a read position drifting past a sample doesn't step
+        the output. Each filter's fractional delay stays between 0.236 and 2
+        samples while it is heard, so both stay well damped. When the read
+        position crosses a sample, the filter whose pair now holds the
+        other's samples takes over the other's memory.
+    */
+    struct Allpass
+    {
+        static constexpr float crossfadeEnd = 0.764f;
+
+        template <typename SampleType>
+        static SampleType interpolate (const SampleType* p, SampleType frac, State<SampleType>& state)
+        {
+            if (frac < state.lastFrac - (SampleType) 0.5)
+                state.lowerPair = state.upperPair;
+            else if (frac > state.lastFrac + (SampleType) 0.5)
+                state.upperPair = state.lowerPair;
+
+            state.lastFrac = frac;
+
+            const auto lower = filter (p[1], p[2], (SampleType) 1 - frac, state.lowerPair);
+            const auto upper = filter (p[2], p[3], (SampleType) 2 - frac, state.upperPair);
+
+            const auto t = jmin (frac * (SampleType) (1.0f / crossfadeEnd), (SampleType) 1);
+            const auto weight = t * t * ((SampleType) 3 - (SampleType) 2 * t);
+            return lower + weight * (upper - lower);
+        }
+
+       #if EZ_CHORUS_VOICE_LANES
+        static __m128 interpolate4 (const __m128* p, __m128 frac, LaneState& state)
+        {
+            const auto half = _mm_set1_ps (0.5f);
+            const auto select = [] (__m128 mask, __m128 ifSet, __m128 otherwise)
+            {
+                return _mm_or_ps (_mm_and_ps (mask, ifSet), _mm_andnot_ps (mask, otherwise));
+            };
+
+            const auto movedUp = _mm_cmplt_ps (frac, _mm_sub_ps (state.lastFrac, half));
+            const auto movedDown = _mm_cmpgt_ps (frac, _mm_add_ps (state.lastFrac, half));
+            state.lowerPair = select (movedUp, state.upperPair, state.lowerPair);
+            state.upperPair = select (movedDown, state.lowerPair, state.upperPair);
+            state.lastFrac = frac;
+
+            const auto one = _mm_set1_ps (1.0f);
+            const auto lower = filter4 (p[1], p[2], _mm_sub_ps (one, frac), state.lowerPair);
+            const auto upper = filter4 (p[2], p[3], _mm_sub_ps (_mm_set1_ps (2.0f), frac), state.upperPair);
+
+            const auto t = _mm_min_ps (_mm_mul_ps (frac, _mm_set1_ps (1.0f / crossfadeEnd)), one);
+            const auto weight = _mm_mul_ps (_mm_mul_ps (t, t), _mm_sub_ps (_mm_set1_ps (3.0f), _mm_add_ps (t, t)));
+            return _mm_add_ps (lower, _mm_mul_ps (weight, _mm_sub_ps (upper, lower)));
+        }
+       #endif
+
+    private:
+        template <typename SampleType>
+        static SampleType filter (SampleType older, SampleType newer, SampleType delay, SampleType& previous)
+        {
+            const auto alpha = ((SampleType) 1 - delay) / ((SampleType) 1 + delay);
+            previous = older + alpha * (newer - previous);
+            return previous;
+        }
+
+       #if EZ_CHORUS_VOICE_LANES
+        static __m128 filter4 (__m128 older, __m128 newer, __m128 delay, __m128& previous)
+        {
+            const auto one = _mm_set1_ps (1.0f);
+            const auto alpha = _mm_div_ps (_mm_sub_ps (one, delay), _mm_add_ps (one, delay));
+            previous = _mm_add_ps (older, _mm_mul_ps (alpha, _mm_sub_ps (newer, previous)));
+            return previous;
+        }
+       #endif
+    };
+}
@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+    HalfBandResampler.cpp
+    Half-band FIR decimation and interpolation by two, for running the wet
+    path below the host rate.
+
+  ==============================================================================
+*/
+
+#include "HalfBandResampler.h"
+
+//==============================================================================
+template <typename SampleType>
+HalfBandResampler<SampleType>::Design::Design()
+{
+    // The odd taps of a windowed sinc cut off at a quarter of the rate; the
+    // even ones, apart from the centre tap of 0.5, are zero.
+    constexpr double beta = 8.0;
+    constexpr double halfWidth = 2 * numSideTaps;
+
+    const auto besselI0 = [] (double x)
+    {
+        double sum = 1, term = 1;
+        for (int k = 1; term > 1.0e-12 * sum; k++)
+        {
+            term *= (x / (2 * k)) * (x / (2 * k));
+            sum += term;
+        }
+        return sum;
+    };
+
+    double total = 0;
+
+    for (int j = 0; j < numSideTaps; j++)
+    {
+        const auto offset = 2 * j + 1;
+        const auto ratio = offset / halfWidth;
+        const auto window = besselI0 (beta * std::sqrt (1.0 - ratio * ratio)) / besselI0 (beta);
+        taps[j] = ((j % 2 == 0) ? 1.0 : -1.0) / (MathConstants<double>::pi * offset) * window;
+        total += taps[j];
+    }
+
+    // Unity gain at DC: the centre tap plus both sides sum to one.
+    for (auto& tap : taps)
+        tap *= 0.25 / total;
+}
+
+template <typename SampleType>
+HalfBandResampler<SampleType>::HalfBandResampler()
+{
+    for (int j = 0; j < numSideTaps; j++)
+        coefficients[j] = (SampleType) design->taps[j];
+}
+
+template <typename SampleType>
+void HalfBandResampler<SampleType>::prepare (int numChannels)
+{
+    capacityChannels = numChannels;
+    decimatorHistory.calloc ((size_t) (numChannels * 2 * decimatorLength));
+    interpolatorHistory.calloc ((size_t) (numChannels * 2 * interpolatorLength));
+    reset();
+}
+
+template <typename SampleType>
+void HalfBandResampler<SampleType>::reset()
+{
+    decimatorHistory.clear ((size_t) (capacityChannels * 2 * decimatorLength));
+    interpolatorHistory.clear ((size_t) (capacityChannels * 2 * interpolatorLength));
+    decimatorPosition = decimatorPhase = 0;
+    interpolatorPosition = interpolatorPhase = 0;
+}
+
+template <typename SampleType>
+int HalfBandResampler<SampleType>::decimate (const SampleType* const* input, SampleType* const* output,
+                                             int numChannels, int numSamples)
+{
+    jassert (numChannels <= capacityChannels);
+    constexpr int centre = 2 * numSideTaps - 1;
+
+    int position = decimatorPosition;
+    int numOutputs = 0;
+
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        auto* history = decimatorHistory + ch * 2 * decimatorLength;
+        const auto* in = input[ch];
+        auto* out = output[ch];
+
+        position = decimatorPosition;
+        int phase = decimatorPhase;
+        numOutputs = 0;
+
+        // Each output is written after the input at the same index or later
+        // has been read, so output may alias input.
+        for (int i = 0; i < numSamples; i++)
+        {
+            position = position == 0 ? decimatorLength - 1 : position - 1;
+            history[position] = history[position + decimatorLength] = in[i];
+
+            if (phase == 0)
+            {
+                const auto* x = history + position;     // x[k] is k samples old
+                auto y = x[centre] * (SampleType) 0.5;
+
+                for (int j = 0; j < numSideTaps; j++)
+                    y += coefficients[j] * (x[centre - 2 * j - 1] + x[centre + 2 * j + 1]);
+
+                out[numOutputs++] = y;
+            }
+
+            phase ^= 1;
+        }
+    }
+
+    decimatorPosition = position;
+    decimatorPhase = (decimatorPhase + numSamples) & 1;
+    return numOutputs;
+}
+
+template <typename SampleType>
+void HalfBandResampler<SampleType>::interpolate (const SampleType* const* input, SampleType* const* output,
+                                                 int numChannels, int numSamples)
+{
+    jassert (numChannels <= capacityChannels);
+
+    int position = interpolatorPosition;
+
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        auto* history = interpolatorHistory + ch * 2 * interpolatorLength;
+        const auto* in = input[ch];
+        auto* out = output[ch];
+
+        position = interpolatorPosition;
+        int phase = interpolatorPhase;
+
+        // Zero-stuffing the input leaves the even taps for the samples that
+        // line up with an input and the centre tap alone for the ones between.
+        for (int i = 0; i < numSamples; i++)
+        {
+            if (phase == 0)
+            {
+                position = position == 0 ? interpolatorLength - 1 : position - 1;
+                history[position] = history[position + interpolatorLength] = *in++;
+
+                const auto* x = history + position;
+                SampleType y = 0;
+
+                for (int j = 0; j < numSideTaps; j++)
+                    y += coefficients[j] * (x[numSideTaps - 1 - j] + x[numSideTaps + j]);
+
+                out[i] = 2 * y;
+            }
+            else
+            {
+                out[i] = history[position + numSideTaps - 1];
+            }
+
+            phase ^= 1;
+        }
+    }
+
+    interpolatorPosition = position;
+    interpolatorPhase = (interpolatorPhase + numSamples) & 1;
+}
+
+//==============================================================================
+template class HalfBandResampler<float>;
+template class HalfBandResampler<double>;
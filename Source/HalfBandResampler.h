@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    HalfBandResampler.h
+    Half-band FIR decimation and interpolation by two, for running the wet
+    path below the host rate.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace juce;
+
+//==============================================================================
+/**
+    One 2:1 stage. decimate() low-pass filters and keeps every other sample;
+    interpolate() does the reverse, with the same filter.
+
+    The filter is a 47-tap Kaiser-windowed (beta 8) half-band FIR. It is flat
+    to within 0.1 dB up to 0.21 of the higher rate and at least 70 dB down
+    from 0.30. Every other tap is zero and the rest are symmetric, so each
+    output costs 12 multiplies. It is linear phase, and a round trip through
+    decimate() and interpolate() delays the signal by roundTripDelay samples
+    at the higher rate.
+
+    Blocks can be any length. The stage tracks which input sample is kept
+    next, so a block of n samples decimates to n / 2 or n / 2 + 1 samples.
+    interpolate() for the same n consumes exactly as many, as long as both
+    directions see the same sequence of block lengths. Each direction
+    shares its position across channels, so every call must pass the same
+    channels.
+*/
+template <typename SampleType>
+class HalfBandResampler
+{
+public:
+    static constexpr int numSideTaps = 12;     // non-zero taps on each side of the centre
+    static constexpr int numTaps = 4 * numSideTaps - 1;
+    static constexpr int roundTripDelay = numTaps - 1;
+
+    HalfBandResampler();
+
+    /** Allocates the filter histories for up to numChannels channels. */
+    void prepare (int numChannels);
+
+    void reset();
+
+    /** Filters numSamples samples of each channel and writes every other
+        one to output, which may be the input. Returns the number written.
+    */
+    int decimate (const SampleType* const* input, SampleType* const* output, int numChannels, int numSamples);
+
+    /** How many input samples the next interpolate() of numSamples
+        outputs will consume.
+    */
+    int getInterpolatorInputLength (int numSamples) const   { return (numSamples + 1 - interpolatorPhase) / 2; }
+
+    /** Writes numSamples samples at twice the input rate to each channel of
+        output, consuming getInterpolatorInputLength (numSamples) inputs.
+    */
+    void interpolate (const SampleType* const* input, SampleType* const* output, int numChannels, int numSamples);
+
+private:
+    // The filter design, computed once for the whole process. Each
+    // resampler keeps its own copy of the taps next to its histories.
+    struct Design
+    {
+        Design();
+        double taps[numSideTaps];
+    };
+
+    // Each history is stored twice over, so the newest numTaps (or
+    // 2 * numSideTaps) samples are always contiguous from the write position.
+    static constexpr int decimatorLength = numTaps;
+    static constexpr int interpolatorLength = 2 * numSideTaps;
+
+    SharedResourcePointer<Design> design;
+    SampleType coefficients[numSideTaps];
+
+    int capacityChannels = 0;
+    HeapBlock<SampleType> decimatorHistory;
+    HeapBlock<SampleType> interpolatorHistory;
+    int decimatorPosition = 0;
+    int decimatorPhase = 0;
+    int interpolatorPosition = 0;
+    int interpolatorPhase = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HalfBandResampler)
+};
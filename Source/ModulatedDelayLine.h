@@ -0,0 +1,142 @@
+/*
+  ==============================================================================
+
+    ModulatedDelayLine.h
+    Power-of-two circular delay line for the chorus taps.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "HalfFloat.h"
+#include "DelayInterpolation.h"
+
+using namespace juce;
+
+//==============================================================================
+/** How a delay line stores its samples. */
+enum class DelayStorage
+{
+    full,   // the processing type, float or double
+    half    // 16-bit half floats: a quarter of the memory of double, half of float
+};
+
+//==============================================================================
+/**
+    A circular buffer sized to the next power of two above the longest delay
+    the chorus can ask for, so wrapping is a bitmask rather than a branch.
+
+    The first guardSize samples are mirrored past the end of the buffer, which
+    lets an interpolated read touch index - 1 to index + 2 without checking
+    for the wrap.
+
+    StorageType is either SampleType or uint16, for half floats. Compact
+    lines convert each chunk as it is pushed, and each four-sample
+    neighbourhood as it is read.
+*/
+template <typename SampleType, typename StorageType = SampleType>
+class ModulatedDelayLine
+{
+public:
+    static constexpr int guardSize = 4;
+
+    ModulatedDelayLine() = default;
+
+    /** Allocates room for delays up to maximumDelaySamples and clears the line. */
+    void prepare (int maximumDelaySamples)
+    {
+        size = nextPowerOfTwo (maximumDelaySamples + 2);
+        mask = size - 1;
+        buffer.allocate ((size_t) (size + guardSize), true);
+        writePosition = 0;
+    }
+
+    void reset()
+    {
+        buffer.clear ((size_t) (size + guardSize));
+        writePosition = 0;
+    }
+
+    /** True if the line is already long enough for this delay. */
+    bool canHold (int maximumDelaySamples) const    { return maximumDelaySamples + 2 <= size; }
+
+    int getSize() const             { return size; }
+    int getMask() const             { return mask; }
+    int getWritePosition() const    { return writePosition; }
+    const StorageType* getData() const  { return buffer.get(); }
+
+    /** Read positions for the next chunk are expressed relative to this
+        origin (readOrigin + n - delay), which keeps them positive so the
+        integer part can simply be masked.
+    */
+    float getReadOrigin() const     { return (float) (writePosition + size); }
+
+    /** Interpolates the line at each read position using one of the
+        DelayInterpolation kernels. Every position must be at least two
+        samples older than the current write position. state is the
+        interpolator's memory for this tap and must persist between calls.
+    */
+    template <typename Interpolator>
+    void read (const float* readPositions, SampleType* output, int numSamples,
+               DelayInterpolation::State<SampleType>& state) const
+    {
+        auto* data = buffer.get();
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            const auto index = (int) readPositions[i];
+            const auto frac = (SampleType) (readPositions[i] - (float) index);
+
+            if constexpr (isCompact)
+            {
+                SampleType neighbours[4];
+                HalfFloat::unpack4 (neighbours, data + ((index - 1) & mask));
+                output[i] = Interpolator::interpolate (neighbours, frac, state);
+            }
+            else
+            {
+                output[i] = Interpolator::interpolate (data + ((index - 1) & mask), frac, state);
+            }
+        }
+    }
+
+    /** Appends a chunk of samples to the line. */
+    void push (const SampleType* source, int numSamples)
+    {
+        jassert (numSamples <= size);
+        auto* data = buffer.get();
+
+        const int beforeWrap = jmin (numSamples, size - writePosition);
+
+        if constexpr (isCompact)
+        {
+            HalfFloat::pack (data + writePosition, source, beforeWrap);
+            HalfFloat::pack (data, source + beforeWrap, numSamples - beforeWrap);
+        }
+        else
+        {
+            FloatVectorOperations::copy (data + writePosition, source, beforeWrap);
+            FloatVectorOperations::copy (data, source + beforeWrap, numSamples - beforeWrap);
+        }
+
+        std::copy (data, data + guardSize, data + size);
+
+        writePosition = (writePosition + numSamples) & mask;
+    }
+
+    /** Bytes of sample storage, for memory comparisons. */
+    size_t getSizeInBytes() const   { return (size_t) (size + guardSize) * sizeof (StorageType); }
+
+private:
+    static constexpr bool isCompact = std::is_same_v<StorageType, uint16>;
+    static_assert (isCompact || std::is_same_v<StorageType, SampleType>, "Lines store either SampleType or half floats");
+
+    HeapBlock<StorageType> buffer;
+    int size = 0;
+    int mask = 0;
+    int writePosition = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ModulatedDelayLine)
+};
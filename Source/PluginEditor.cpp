@@ -11,13 +11,17 @@
 
 //==============================================================================
 EZChorusAudioProcessorEditor::EZChorusAudioProcessorEditor (EZChorusAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p),
+      feedbackValue (*p.apvts.getRawParameterValue ("FEEDBACK")),
+      mixValue (*p.apvts.getRawParameterValue ("MIX")),
+      rateValue (*p.apvts.getRawParameterValue ("CHORUSRATE")),
+      depthValue (*p.apvts.getRawParameterValue ("CHORUSDEPTH")),
+      offsetValue (*p.apvts.getRawParameterValue ("PHASEOFFSET"))
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
     setLookAndFeel(&otherLookAndFeel);
-    setSize(365, 325);
-    Timer::startTimerHz(20);
+    setSize(365, 520);
     
     feedbackSlider.setLookAndFeel(&otherLookAndFeel);
     offsetSlider.setLookAndFeel(&otherLookAndFeel);
@@ -32,6 +36,41 @@ EZChorusAudioProcessorEditor::EZChorusAudioProcessorEditor (EZChorusAudioProcess
     modDepthAttachment = std::make_unique<SliderAttachment>(audioProcessor.apvts, "CHORUSDEPTH", modDepthSlider);
     modRateAttachment = std::make_unique<SliderAttachment>(audioProcessor.apvts, "CHORUSRATE", modRateSlider);
 
+    shapeBox.addItemList(StringArray { "Sine", "Triangle", "Random" }, 1);
+    shapeAttachment = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.apvts, "LFOSHAPE", shapeBox);
+    addAndMakeVisible(shapeBox);
+    shapeLabel.setText("LFO Shape", dontSendNotification);
+    shapeLabel.attachToComponent(&shapeBox, true);
+
+    voicesBox.addItemList(StringArray { "1", "2", "3", "4", "5", "6", "7", "8" }, 1);
+    voicesAttachment = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.apvts, "VOICES", voicesBox);
+    addAndMakeVisible(voicesBox);
+    voicesLabel.setText("Voices", dontSendNotification);
+    voicesLabel.attachToComponent(&voicesBox, true);
+
+    setSliderParametersHorizontal(spreadSlider, spreadLabel, "Voice Spread");
+    spreadAttachment = std::make_unique<SliderAttachment>(audioProcessor.apvts, "VOICESPREAD", spreadSlider);
+
+    qualityBox.addItemList(StringArray { "Linear", "Hermite", "Lagrange", "Allpass" }, 1);
+    qualityAttachment = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.apvts, "QUALITY", qualityBox);
+    addAndMakeVisible(qualityBox);
+    qualityLabel.setText("Quality", dontSendNotification);
+    qualityLabel.attachToComponent(&qualityBox, true);
+
+    oversamplingBox.addItemList(StringArray { "Off", "2x", "4x" }, 1);
+    oversamplingAttachment = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.apvts, "OVERSAMPLING", oversamplingBox);
+    addAndMakeVisible(oversamplingBox);
+    oversamplingLabel.setText("Oversampling", dontSendNotification);
+    oversamplingLabel.attachToComponent(&oversamplingBox, true);
+
+    economyBox.addItemList(StringArray { "Off", "1/2 Rate", "1/4 Rate" }, 1);
+    economyAttachment = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.apvts, "ECONOMY", economyBox);
+    addAndMakeVisible(economyBox);
+    economyLabel.setText("Economy", dontSendNotification);
+    economyLabel.attachToComponent(&economyBox, true);
+
+    addAndMakeVisible(telemetryView);
+
     setSliderParametersDial(feedbackSlider, true);
     setSliderParametersDial(offsetSlider, true);
     setSliderParametersDial(mixSlider, true);
@@ -43,6 +82,14 @@ EZChorusAudioProcessorEditor::EZChorusAudioProcessorEditor (EZChorusAudioProcess
     mixSlider.setRotaryParameters(4 * pi / 3, 8 * pi /3, true);
     modRateSlider.setRotaryParameters(4 * pi / 3, 8 * pi /3, true);
     modDepthSlider.setRotaryParameters(4 * pi / 3, 8 * pi /3, true);
+
+    // The attachments already listen to the parameters and update the dials
+    // on the message thread, so react to the dials rather than polling.
+    for (auto* dial : { &feedbackSlider, &offsetSlider, &mixSlider, &modRateSlider, &modDepthSlider })
+    {
+        dial->onValueChange = [this, dial] { dialChanged (*dial); };
+        dial->addMouseListener (this, false);
+    }
 }
 
 EZChorusAudioProcessorEditor::~EZChorusAudioProcessorEditor()
@@ -53,16 +100,50 @@ EZChorusAudioProcessorEditor::~EZChorusAudioProcessorEditor()
 //==============================================================================
 void EZChorusAudioProcessorEditor::paint (juce::Graphics& g)
 {
+    const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    if (backgroundImage.isNull() || scale != backgroundScale)
+    {
+        auto& shared = resources->backgrounds[scale];
+        if (shared.isNull())
+            shared = renderBackground(scale);
+
+        backgroundImage = shared;
+        backgroundScale = scale;
+    }
+
+    g.drawImage(backgroundImage, getLocalBounds().toFloat());
+
     auto sliderPosFeedback = feedbackSlider.getValue() * (pi / (pi+.07))/ feedbackSlider.getMaximum();
     auto sliderPosOffset= offsetSlider.getValue() / offsetSlider.getMaximum();
     auto sliderPosMix = mixSlider.getValue() / mixSlider.getMaximum();
     auto sliderPosRate = modRateSlider.getValue() / modRateSlider.getMaximum();
     auto sliderPosDepth = modDepthSlider.getValue() / modDepthSlider.getMaximum();
-    auto titleFont = Font("Euphemia UCAS", 60.0f, Font::plain);
+
+    if (g.clipRegionIntersects(getKnobArea(mixSlider)))
+        otherLookAndFeel.drawRotarySlider(g, row1X, column1Y + 50, sliderWidthAndHeight, sliderWidthAndHeight, sliderPosMix, 4 * pi / 3, 8*pi/3, mixSlider, String("Mix"));
+    if (g.clipRegionIntersects(getKnobArea(offsetSlider)))
+        otherLookAndFeel.drawRotarySlider(g, mixSlider.getRight() + horizontalDistance, column1Y, sliderWidthAndHeight, sliderWidthAndHeight, sliderPosOffset, 4 * pi / 3, 8 * pi /3, offsetSlider, String("Phase Offset"));
+    if (g.clipRegionIntersects(getKnobArea(feedbackSlider)))
+        otherLookAndFeel.drawRotarySlider(g, offsetSlider.getX(), offsetSlider.getBottom() + distanceBetweenSlidersVertical, sliderWidthAndHeight, sliderWidthAndHeight, sliderPosFeedback , 4 * pi / 3, 8 * pi /3, feedbackSlider, String("Feedback"));
+    if (g.clipRegionIntersects(getKnobArea(modRateSlider)))
+        otherLookAndFeel.drawRotarySlider(g, offsetSlider.getRight() + horizontalDistance, offsetSlider.getY(), sliderWidthAndHeight, sliderWidthAndHeight, sliderPosRate, 4 * pi / 3, 8 * pi /3, modRateSlider, String("Mod Rate"));
+    if (g.clipRegionIntersects(getKnobArea(modDepthSlider)))
+        otherLookAndFeel.drawRotarySlider(g, feedbackSlider.getRight() + horizontalDistance, feedbackSlider.getY(), sliderWidthAndHeight, sliderWidthAndHeight, sliderPosDepth, 4 * pi / 3, 8 * pi /3, modDepthSlider, String("Mod Depth"));
+    if (g.clipRegionIntersects(paramTextArea))
+        drawParamText(g);
+}
+
+Image EZChorusAudioProcessorEditor::renderBackground (float scale)
+{
+    Image image(Image::ARGB, roundToInt(getWidth() * scale), roundToInt(getHeight() * scale), true);
+
+    Graphics g(image);
+    g.addTransform(AffineTransform::scale(scale));
+
     auto fillRect2 = Rectangle<float>(mixSlider.getX()-5, mixSlider.getY() - 5, mixSlider.getWidth()+10, mixSlider.getHeight() + 25);
-       
+
     g.fillAll (Colours::black);
-    g.setFont(titleFont);
+    g.setFont(resources->titleFont);
     g.setColour(Colours::skyblue);
     g.setOpacity(1);
     g.drawFittedText(String("EZ Chorus"), 150, 0, 200, 60, Justification::centredTop, 1);
@@ -71,15 +152,34 @@ void EZChorusAudioProcessorEditor::paint (juce::Graphics& g)
     g.fillRoundedRectangle(fillRect2, 10);
     g.setColour(Colours::white);
     g.drawRoundedRectangle(fillRect2, 10, 2);
-    
+
     drawGroupRectangle(offsetSlider, feedbackSlider, String("Stuff"), g);
     drawGroupRectangle(modRateSlider, modDepthSlider, String("Stuff"), g);
-    drawRotarySlider(g, row1X, column1Y + 50, sliderWidthAndHeight, sliderWidthAndHeight, sliderPosMix, 4 * pi / 3, 8*pi/3, mixSlider, String("Mix"));
-    drawRotarySlider(g, mixSlider.getRight() + horizontalDistance, column1Y, sliderWidthAndHeight, sliderWidthAndHeight, sliderPosOffset, 4 * pi / 3, 8 * pi /3, offsetSlider, String("Phase Offset"));
-    drawRotarySlider(g, offsetSlider.getX(), offsetSlider.getBottom() + distanceBetweenSlidersVertical, sliderWidthAndHeight, sliderWidthAndHeight, sliderPosFeedback , 4 * pi / 3, 8 * pi /3, feedbackSlider, String("Feedback"));
-    drawRotarySlider(g, offsetSlider.getRight() + horizontalDistance, offsetSlider.getY(), sliderWidthAndHeight, sliderWidthAndHeight, sliderPosRate, 4 * pi / 3, 8 * pi /3, modRateSlider, String("Mod Rate"));
-    drawRotarySlider(g, feedbackSlider.getRight() + horizontalDistance, feedbackSlider.getY(), sliderWidthAndHeight, sliderWidthAndHeight, sliderPosDepth, 4 * pi / 3, 8 * pi /3, modDepthSlider, String("Mod Depth"));
-    drawParamText(g);
+    return image;
+}
+
+Rectangle<int> EZChorusAudioProcessorEditor::getKnobArea (const Slider& slider) const
+{
+    // The dial plus the name drawn underneath it.
+    return slider.getBounds().withBottom(slider.getBottom() + 20);
+}
+
+void EZChorusAudioProcessorEditor::dialChanged (Slider& slider)
+{
+    repaint(getKnobArea(slider));
+
+    if (slider.isMouseOverOrDragging())
+        repaint(paramTextArea);
+}
+
+void EZChorusAudioProcessorEditor::mouseEnter (const MouseEvent&)
+{
+    repaint(paramTextArea);
+}
+
+void EZChorusAudioProcessorEditor::mouseExit (const MouseEvent&)
+{
+    repaint(paramTextArea);
 }
 
 void EZChorusAudioProcessorEditor::resized()
@@ -89,35 +189,28 @@ void EZChorusAudioProcessorEditor::resized()
     feedbackSlider.setBounds(offsetSlider.getX(), offsetSlider.getBottom() + distanceBetweenSlidersVertical, sliderWidthAndHeight, sliderWidthAndHeight);
     modRateSlider.setBounds(offsetSlider.getRight() + horizontalDistance, offsetSlider.getY(), sliderWidthAndHeight, sliderWidthAndHeight);
     modDepthSlider.setBounds(feedbackSlider.getRight() + horizontalDistance, feedbackSlider.getY(), sliderWidthAndHeight, sliderWidthAndHeight);
+    shapeBox.setBounds(row1X + 75, optionsRowY, sliderWidthAndHeight, 24);
+    voicesBox.setBounds(shapeBox.getRight() + 70, optionsRowY, 80, 24);
+    sliderResizedHorizontal(spreadSlider, spreadLabel, row1X, shapeBox.getBottom() + 6);
+    qualityBox.setBounds(voicesBox.getX(), shapeBox.getBottom() + 10, 80, 24);
+    oversamplingBox.setBounds(voicesBox.getX(), qualityBox.getBottom() + 6, 80, 24);
+    economyBox.setBounds(shapeBox.getX(), oversamplingBox.getY(), sliderWidthAndHeight, 24);
+    telemetryView.setBounds(row1X, oversamplingBox.getBottom() + 10, 345, 90);
+    backgroundImage = {};
 }
 void EZChorusAudioProcessorEditor::drawParamText(Graphics &g)
 {
     auto text = String("");
     if (feedbackSlider.isMouseOverOrDragging())
-    {
-        auto& fBack = *audioProcessor.apvts.getRawParameterValue("FEEDBACK");
-        text = String("Feedback: " + std::to_string(fBack));
-    }
+        text = "Feedback: " + String(feedbackValue.load(), 2);
     if (mixSlider.isMouseOverOrDragging())
-    {
-        auto& mix = *audioProcessor.apvts.getRawParameterValue("MIX");
-        text = String("Mix:    " + std::to_string(mix));
-    }
+        text = "Mix:    " + String(mixValue.load(), 2);
     if (modRateSlider.isMouseOverOrDragging())
-    {
-        auto& rate = *audioProcessor.apvts.getRawParameterValue("CHORUSRATE");
-        text = String("Mod Rate: " + std::to_string(rate) + "Hz");
-    }
+        text = "Mod Rate: " + String(rateValue.load(), 2) + "Hz";
     if (modDepthSlider.isMouseOverOrDragging())
-    {
-        auto& depth = *audioProcessor.apvts.getRawParameterValue("CHORUSDEPTH");
-        text = String("Mod Depth: " + std::to_string(depth));
-    }
+        text = "Mod Depth: " + String(depthValue.load(), 2);
     if (offsetSlider.isMouseOverOrDragging())
-    {
-        auto& offset = *audioProcessor.apvts.getRawParameterValue("PHASEOFFSET");
-        text = String("Phase Offset: " + std::to_string(offset));
-    }
+        text = "Phase Offset: " + String(offsetValue.load(), 2);
     auto textRect = Rectangle<float>(2, 10, 125, 50);
     g.setColour(Colours::white);
     g.drawFittedText(text, 5, 10, 100, 50, Justification::centredTop, 2);
@@ -126,7 +219,3 @@ void EZChorusAudioProcessorEditor::drawParamText(Graphics &g)
     g.setOpacity(.5);
     g.drawRoundedRectangle(textRect, 10, 2);
 }
-void EZChorusAudioProcessorEditor::timerCallback()
-{
-    repaint();
-}
@@ -10,6 +10,7 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "TelemetryView.h"
 #include <iostream>
 
 //==============================================================================
@@ -56,12 +57,31 @@ public:
         g.setColour (juce::Colours::white);
         g.fillPath (p);
         // textbox
-        g.setFont(24.0f);
+        g.setFont(labelFont);
         g.drawFittedText(label , x, slider.getBottom()-5, width, 25, Justification::centred, 3);
         g.setColour(Colours::whitesmoke);
     }
+
+    Font labelFont { Font::getDefaultSansSerifFontName(), 24.0f, Font::plain };
 };
-class EZChorusAudioProcessorEditor  : public juce::AudioProcessorEditor, public OtherLookAndFeel, public Timer
+
+//==============================================================================
+/**
+    Everything the editors draw with that never changes. The first editor
+    opened in the process creates it and the last one closed frees it, so
+    further editors only build their own components.
+*/
+struct EditorResources
+{
+    OtherLookAndFeel lookAndFeel;
+    Font titleFont { "Euphemia UCAS", 60.0f, Font::plain };
+
+    // The editor has a fixed size and layout, so its background only
+    // depends on the display's pixel scale.
+    std::map<float, Image> backgrounds;
+};
+
+class EZChorusAudioProcessorEditor  : public juce::AudioProcessorEditor
 {
 public:
     EZChorusAudioProcessorEditor (EZChorusAudioProcessor&);
@@ -70,6 +90,8 @@ public:
     //==============================================================================
     void paint (juce::Graphics&) override;
     void resized() override;
+    void mouseEnter (const MouseEvent&) override;
+    void mouseExit (const MouseEvent&) override;
     
          //============//
         //MY FUNCTIONS//
@@ -146,18 +168,49 @@ public:
     
     }
     void drawParamText(Graphics& g);
-    void timerCallback() override;
 private:
+    // The title and panels never change, so they are drawn once into an image
+    // at the display's pixel scale, which every editor shares. Knobs and the
+    // value box are repainted only when their parameter changes or the
+    // hovered knob does.
+    Image renderBackground (float scale);
+    Rectangle<int> getKnobArea (const Slider& slider) const;
+    void dialChanged (Slider& slider);
+
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     EZChorusAudioProcessor& audioProcessor;
-    OtherLookAndFeel otherLookAndFeel;
+
+    // The values drawParamText() shows, looked up once rather than by ID on
+    // every repaint.
+    std::atomic<float>& feedbackValue;
+    std::atomic<float>& mixValue;
+    std::atomic<float>& rateValue;
+    std::atomic<float>& depthValue;
+    std::atomic<float>& offsetValue;
+
+    // Declared before the components so it outlives every one using it.
+    SharedResourcePointer<EditorResources> resources;
+    OtherLookAndFeel& otherLookAndFeel { resources->lookAndFeel };
         
     Slider feedbackSlider;
     Slider offsetSlider;
     Slider mixSlider;
     Slider modRateSlider;
     Slider modDepthSlider;
+    ComboBox shapeBox;
+    Label shapeLabel;
+    ComboBox voicesBox;
+    Label voicesLabel;
+    Slider spreadSlider;
+    Label spreadLabel;
+    ComboBox qualityBox;
+    Label qualityLabel;
+    ComboBox oversamplingBox;
+    Label oversamplingLabel;
+    ComboBox economyBox;
+    Label economyLabel;
+    TelemetryView telemetryView { audioProcessor.getTelemetry(), audioProcessor.getPerfStats() };
     
     
     std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> feedbackAttachment;
@@ -165,6 +218,12 @@ private:
     std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> mixAttachment;
     std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> modRateAttachment;
     std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> modDepthAttachment;
+    std::unique_ptr<AudioProcessorValueTreeState::ComboBoxAttachment> shapeAttachment;
+    std::unique_ptr<AudioProcessorValueTreeState::ComboBoxAttachment> voicesAttachment;
+    std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> spreadAttachment;
+    std::unique_ptr<AudioProcessorValueTreeState::ComboBoxAttachment> qualityAttachment;
+    std::unique_ptr<AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingAttachment;
+    std::unique_ptr<AudioProcessorValueTreeState::ComboBoxAttachment> economyAttachment;
 
     const float pi = MathConstants<const float>::pi;
     int sliderWidthAndHeight = 100;
@@ -172,5 +231,10 @@ private:
     int horizontalDistance = 20;
     int row1X = 10;
     int column1Y = 75;
+    int optionsRowY = 322;
+
+    Image backgroundImage;
+    float backgroundScale = 0;
+    Rectangle<int> paramTextArea { 0, 8, 130, 54 };
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EZChorusAudioProcessorEditor)
 };
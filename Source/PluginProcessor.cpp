@@ -28,36 +28,25 @@ EZChorusAudioProcessor::EZChorusAudioProcessor()
         std::make_unique<AudioParameterFloat>(ParameterID("MIX",1), "Mix", NormalisableRange<float> { 0.0f, 1.0f, .001f }, 0.5f),
         std::make_unique<AudioParameterFloat>(ParameterID("CHORUSDEPTH",1), "Chorus Depth", NormalisableRange<float> { 0.0f, 1.0f, .001f }, .35f),
         std::make_unique<AudioParameterFloat>(ParameterID("CHORUSRATE",1), "Chorus Rate", NormalisableRange<float> { 0.0f, 5.0f, .001f }, .2f),
+        std::make_unique<AudioParameterChoice>(ParameterID("LFOSHAPE",1), "LFO Shape", StringArray { "Sine", "Triangle", "Random" }, 0),
+        std::make_unique<AudioParameterChoice>(ParameterID("VOICES",1), "Voices", StringArray { "1", "2", "3", "4", "5", "6", "7", "8" }, 0),
+        std::make_unique<AudioParameterFloat>(ParameterID("VOICESPREAD",1), "Voice Spread", NormalisableRange<float> { 0.0f, 1.0f, .001f }, .5f),
+        std::make_unique<AudioParameterChoice>(ParameterID("QUALITY",1), "Quality", StringArray { "Linear", "Hermite", "Lagrange", "Allpass" }, 0),
+        std::make_unique<AudioParameterChoice>(ParameterID("OVERSAMPLING",1), "Oversampling", StringArray { "Off", "2x", "4x" }, 0),
+        std::make_unique<AudioParameterChoice>(ParameterID("ECONOMY",1), "Economy", StringArray { "Off", "1/2 Rate", "1/4 Rate" }, 0),
+        std::make_unique<AudioParameterBool>(ParameterID("BYPASS",1), "Bypass", false),
        }
        )
 #endif
 {
-    delayBufferRight = nullptr;
-    delayBufferLeft = nullptr;
-
-    bufferWriteHead = 0;
-    bufferLength = 0;
-    bufferLength = 0;
-
-    delayTimeSamples = 0;
-    
-    feedbackLeft = 0;
-    feedbackRight = 0;
-    lfoPhase = 0;
+    floatChorus.setMeteringEnabled (true);
+    doubleChorus.setMeteringEnabled (true);
+    startTimerHz (10);
 }
 
 EZChorusAudioProcessor::~EZChorusAudioProcessor()
 {
-    if (delayBufferRight != nullptr)
-    {
-        delete [] delayBufferRight;
-        delayBufferRight = nullptr;
-    }
-    if (delayBufferLeft != nullptr)
-    {
-        delete [] delayBufferLeft;
-        delayBufferLeft = nullptr;
-    }
+    stopTimer();
 }
 
 //==============================================================================
@@ -95,62 +84,100 @@ bool EZChorusAudioProcessor::isMidiEffect() const
 
 double EZChorusAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return ChorusStateBase::getTailLengthSeconds (apvts.getRawParameterValue ("FEEDBACK")->load());
 }
 
 int EZChorusAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return ChorusPresets::getNumPresets();
 }
 
 int EZChorusAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram.load();
 }
 
 void EZChorusAudioProcessor::setCurrentProgram (int index)
 {
+    if (! isPositiveAndBelow (index, ChorusPresets::getNumPresets()))
+        return;
+
+    currentProgram.store (index);
+    ++programChanges;
+    ChorusPresets::apply (ChorusPresets::getPreset (index), apvts);
 }
 
 const juce::String EZChorusAudioProcessor::getProgramName (int index)
 {
-    return {};
+    if (! isPositiveAndBelow (index, ChorusPresets::getNumPresets()))
+        return {};
+
+    return ChorusPresets::getPreset (index).name;
 }
 
 void EZChorusAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    // The built-in presets can't be renamed.
+    juce::ignoreUnused (index, newName);
 }
 
 //==============================================================================
 void EZChorusAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
+    const auto numChannels = jmin (getTotalNumOutputChannels(), ChorusStateBase::maxChannels);
 
-    bufferLength = sampleRate * (MAX_DELAY_TIME);
-    lfoPhase = 0;
-    if (delayBufferLeft == nullptr)
-        {
-            delete [] delayBufferLeft;
-            delayBufferLeft = new float[bufferLength];
-        }
-    zeromem(delayBufferLeft, bufferLength * sizeof(float));
-    
-    if (delayBufferRight == nullptr)
-        {
-            delete [] delayBufferRight;
-            delayBufferRight = new float[bufferLength];
-        }
+    // Wide beds rendered offline share their channels out over a few worker
+    // threads. The pool is only ever used when the host is non-realtime.
+    if (isNonRealtime() && numChannels >= parallelChannelThreshold && channelWorkers == nullptr)
+        channelWorkers = std::make_unique<ChannelWorkerPool> (jmin (maxChannelWorkers, SystemStats::getNumCpus() - 1));
 
-    // Clear the buffers after instantiating!
-    zeromem(delayBufferRight, bufferLength * sizeof(float));
+    const auto maxConcurrency = channelWorkers != nullptr ? channelWorkers->getNumWorkers() + 1 : 1;
+    const dsp::ProcessSpec spec { sampleRate, (uint32) samplesPerBlock, (uint32) numChannels };
 
-    bufferWriteHead = 0;
+    // An instance prepared while bypassed starts out fully bypassed.
+    const auto bypassed = bypassParameter->load() >= 0.5f;
+
+    // The state is built for the current oversampling factor; the timer
+    // builds a bigger one if it is raised later.
+    if (isUsingDoublePrecision())
+    {
+        doubleChorus.setSettings (parameters.get());
+        doubleChorus.prepare (spec, maxConcurrency);
+        doubleBypass.prepare (spec, bypassed);
+    }
+    else
+    {
+        floatChorus.setSettings (parameters.get());
+        floatChorus.prepare (spec, maxConcurrency);
+        floatBypass.prepare (spec, bypassed);
+    }
+
+    // The chorus picks up the oversampling factor on the audio thread, but
+    // the host should know the latency before the first block.
+    reportedLatency = ChorusStateBase::getOversamplingLatency (parameters.get().oversamplingFactor);
+    pendingLatency.store (-1);
+    setLatencySamples (reportedLatency);
+
+    telemetry.prepare (sampleRate);
+
+    // A state restored before playback starts needs no crossfade.
+    programFadeSamples = (int) std::ceil (ChorusParameterRamps::mixSmoothingSeconds * sampleRate);
+    programChangesSeen = programChanges.load();
+    programFadeRemaining = 0;
+    programSwitchPending = false;
+    lastSettings = parameters.get();
+
+   #if EZ_CHORUS_PERF_STATS
+    perfStats.prepare (sampleRate);
+   #endif
 }
 
 void EZChorusAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    floatChorus.collectGarbage();
+    doubleChorus.collectGarbage();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -160,12 +187,10 @@ bool EZChorusAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Every channel gets its own delay line and LFO tap, so any layout from
+    // mono up to a 16 channel immersive bed works.
+    if (layouts.getMainOutputChannelSet().isDisabled()
+     || layouts.getMainOutputChannelSet().size() > ChorusStateBase::maxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -179,85 +204,126 @@ bool EZChorusAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 }
 #endif
 
-void EZChorusAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+void EZChorusAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    process (buffer, floatChorus, floatBypass, false);
+}
+
+void EZChorusAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    process (buffer, doubleChorus, doubleBypass, false);
+}
+
+// Hosts that bypass without the BYPASS parameter call these instead; the
+// tail rings out the same way.
+void EZChorusAudioProcessor::processBlockBypassed (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    process (buffer, floatChorus, floatBypass, true);
+}
+
+void EZChorusAudioProcessor::processBlockBypassed (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    process (buffer, doubleChorus, doubleBypass, true);
+}
+
+template <typename SampleType>
+void EZChorusAudioProcessor::process (AudioBuffer<SampleType>& buffer, ChorusProcessor<SampleType>& chorus,
+                                      ChorusBypass<SampleType>& bypass, bool hostBypassed)
 {
     juce::ScopedNoDenormals noDenormals;
+   #if EZ_CHORUS_PERF_STATS
+    ChorusPerfStats::ScopedBlockTimer blockTimer (perfStats, buffer.getNumSamples());
+   #endif
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
     
-    auto& fBack = *apvts.getRawParameterValue("FEEDBACK");
-    auto& mix = *apvts.getRawParameterValue("MIX");
-    auto& modRate = *apvts.getRawParameterValue("CHORUSRATE");
-    auto& modDepth = *apvts.getRawParameterValue("CHORUSDEPTH");
-    auto& phaseOffset = *apvts.getRawParameterValue("PHASEOFFSET");
-
-    
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
-    
-    float* leftBuffer = buffer.getWritePointer(0);
-    float* rightBuffer = buffer.getWritePointer(1);
-    
-    for (int sample = 0; sample < buffer.getNumSamples(); sample++)
+
+    chorus.setSettings (getBlockSettings (chorus, buffer.getNumSamples()));
+    chorus.setWorkerPool (isNonRealtime() ? channelWorkers.get() : nullptr);
+
+    dsp::AudioBlock<SampleType> block (buffer.getArrayOfWritePointers(),
+                                       (size_t) jmin (buffer.getNumChannels(), totalNumOutputChannels),
+                                       (size_t) buffer.getNumSamples());
+    const auto bypassed = hostBypassed || bypassParameter->load (std::memory_order_relaxed) >= 0.5f;
+
+    const auto chorusRan = bypass.process (block, chorus, bypassed, reportedLatency);
+
+    if (chorusRan && chorus.getLatencySamples() != reportedLatency)
     {
-        delayBufferRight[bufferWriteHead] = rightBuffer[sample] + feedbackRight;
-        delayBufferLeft[bufferWriteHead] = leftBuffer[sample] + feedbackLeft;
-        
-        float lfoLeft = sin(2 * M_PI * lfoPhase);
-        float lfoPhaseRight = lfoPhase + phaseOffset;
-        if (lfoPhaseRight > 1)
-            lfoPhase -= 1;
-        
-        float lfoRight = sin(2 * M_PI * lfoPhaseRight);
-        
-        lfoPhase += modRate / getSampleRate();
-        if (lfoPhase > 1)
-            lfoPhase -= 1;
-        lfoRight *= modDepth;
-        lfoLeft *= modDepth;
-        
-        float lfoMappedLeft = jmap(lfoLeft, -1.0f, 1.0f, 0.005f, 0.03f);
-        float lfoMappedRight = jmap(lfoRight, -1.0f, 1.0f, 0.005f, 0.03f);
-        float delayTimeSamplesLeft = getSampleRate() * lfoMappedLeft;
-        float delayTimeSamplesRight = getSampleRate() * lfoMappedRight;
-        
-        float readHeadLeft = bufferWriteHead - delayTimeSamplesLeft;
-        
-        if (readHeadLeft < 0)
-            readHeadLeft += bufferLength;
-        
-        float readHeadRight = bufferWriteHead - delayTimeSamplesRight;
-        if (readHeadRight < 0 )
-            readHeadRight += bufferLength;
-        
-        int rHeadLX = (int) readHeadLeft;
-        int rHeadLX1 = rHeadLX + 1;
-        float rHeadFloatL = readHeadLeft - rHeadLX;
-        if (rHeadLX1 > bufferLength)
-            rHeadLX1 -= bufferLength;
-        
-        int rHeadRX = (int) readHeadRight;
-        int rHeadRX1 = rHeadRX + 1;
-        float rHeadFloatR = readHeadRight - rHeadRX;
-        if (rHeadRX1 > bufferLength)
-            rHeadRX1 -= bufferLength;
-        
-        float delaySampleLeft = lerp(delayBufferLeft[rHeadLX], delayBufferLeft[rHeadLX1], rHeadFloatL);
-        float delaySampleRight = lerp(delayBufferRight[rHeadRX], delayBufferRight[rHeadRX1], rHeadFloatR);
-
-        feedbackLeft = fBack * delaySampleLeft;
-        feedbackRight = fBack * delaySampleRight;
-        
-        bufferWriteHead++;
-        
-        buffer.setSample(0, sample, buffer.getSample(0, sample) * (1-mix) + delaySampleLeft * mix);
-        buffer.setSample(1, sample, buffer.getSample(1, sample) * (1-mix) + delaySampleRight * mix);
-
-        if (bufferWriteHead >= bufferLength)
-            bufferWriteHead = 0;
-        }
-    
-    
+        reportedLatency = chorus.getLatencySamples();
+        pendingLatency.store (reportedLatency, std::memory_order_relaxed);
+    }
+
+    // Once fully bypassed the chorus isn't called, so the meters drop to 0.
+    if (auto* frame = telemetry.accumulate (buffer.getNumSamples(),
+                                            chorusRan ? chorus.getInputPeak() : 0.0f,
+                                            chorusRan ? chorus.getOutputPeak() : 0.0f,
+                                            chorusRan ? chorus.getWetPeak() : 0.0f))
+    {
+        chorus.fillTelemetry (*frame);
+        telemetry.publish();
+    }
+}
+
+template <typename SampleType>
+ChorusSettings EZChorusAudioProcessor::getBlockSettings (ChorusProcessor<SampleType>& chorus, int numSamples)
+{
+    // Read the parameters before the change count: if any of a new
+    // program's values are visible here, so is the change.
+    auto settings = parameters.get();
+
+    if (const auto changes = programChanges.load(); changes != programChangesSeen)
+    {
+        programChangesSeen = changes;
+        programFadeRemaining = programFadeSamples;
+    }
+
+    // The fades are the mix ramp itself: down to dry on the old settings,
+    // then, once the lines are cleared, up again on the new ones.
+    if (programFadeRemaining > 0)
+    {
+        settings = lastSettings;
+        settings.mix = 0;
+        programFadeRemaining -= numSamples;
+        programSwitchPending = programFadeRemaining <= 0;
+    }
+    else if (programSwitchPending)
+    {
+        programSwitchPending = false;
+        settings.mix = 0;
+        chorus.setSettings (settings);
+        chorus.reset();
+    }
+
+    lastSettings = settings;
+    return settings;
+}
+
+void EZChorusAudioProcessor::timerCallback()
+{
+    const auto latency = pendingLatency.exchange (-1, std::memory_order_relaxed);
+    if (latency >= 0 && latency != getLatencySamples())
+        setLatencySamples (latency);
+
+    // States the audio thread swapped out since the last prepareToPlay.
+    floatChorus.collectGarbage();
+    doubleChorus.collectGarbage();
+
+    // Wakes the editor's telemetry view if it stopped while nothing played.
+    telemetry.notifyIfReady();
+
+    prepareForOversampling();
+}
+
+void EZChorusAudioProcessor::prepareForOversampling()
+{
+    // An oversampling factor the current state can't run needs a new one.
+    if (isUsingDoublePrecision())
+        doubleChorus.prepareForOversampling();
+    else
+        floatChorus.prepareForOversampling();
 }
 
 //==============================================================================
@@ -274,18 +340,21 @@ juce::AudioProcessorEditor* EZChorusAudioProcessor::createEditor()
 //==============================================================================
 void EZChorusAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-    auto state = apvts.copyState();
-    std::unique_ptr<juce::XmlElement> xml (state.createXml());
-    copyXmlToBinary (*xml, destData);
+    ChorusPresets::writeState (apvts, currentProgram.load(), destData);
 }
 
 void EZChorusAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    ++programChanges;
+
+    int program = 0;
+    if (ChorusPresets::readState (data, sizeInBytes, apvts, program))
+    {
+        currentProgram.store (program);
+        return;
+    }
+
+    // Sessions saved before the binary format stored the parameter tree as XML.
     std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
         if (xmlState.get() != nullptr)
             if (xmlState->hasTagName (apvts.state.getType()))
@@ -298,10 +367,3 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
     return new EZChorusAudioProcessor();
 }
-
-float EZChorusAudioProcessor::lerp(float sample1, float sample2, float inPhase)
-{
-    return (1 - inPhase) * sample1 + inPhase * sample2;
-}
-
-
@@ -9,31 +9,72 @@
 #pragma once
 
 #include <JuceHeader.h>
-#define MAX_DELAY_TIME 2
-#include <math.h>
+#include "ChorusProcessor.h"
+#include "ChorusBypass.h"
+#include "ChorusPerfStats.h"
+#include "ChorusPresets.h"
 //==============================================================================
 /**
 */
 using namespace juce;
 
 //===================================================================================
-class EZChorusAudioProcessor  :   public AudioProcessor
-                                
+class EZChorusAudioProcessor  :   public AudioProcessor,
+                                  private Timer
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
 {
 private:
-    float feedbackRight;
-    float feedbackLeft;
-    float *delayBufferRight;
-    float *delayBufferLeft;
-    int bufferWriteHead;
-    int bufferLength;
-    float delayTimeSamples;
-    float lfoPhase;
+    // All of the DSP. Only the one matching the host's processing precision
+    // is prepared.
+    ChorusProcessor<float> floatChorus;
+    ChorusProcessor<double> doubleChorus;
+
+    // Bypass, from the BYPASS parameter or the host, fades the chorus out,
+    // lets its tail ring and then stops calling it.
+    ChorusBypass<float> floatBypass;
+    ChorusBypass<double> doubleBypass;
+
+    template <typename SampleType>
+    void process (AudioBuffer<SampleType>& buffer, ChorusProcessor<SampleType>& chorus,
+                  ChorusBypass<SampleType>& bypass, bool hostBypassed);
+
+    static constexpr int parallelChannelThreshold = 6;
+    static constexpr int maxChannelWorkers = 4;
+    std::unique_ptr<ChannelWorkerPool> channelWorkers;
+
+    // setLatencySamples() notifies the host under a lock, so the audio thread
+    // only records the new value and the timer passes it on.
+    int reportedLatency = 0;
+    std::atomic<int> pendingLatency { -1 };
+    void timerCallback() override;
+
+    // Decimated scope and meter readings for the editor.
+    ChorusTelemetry telemetry;
+
+    // Program changes and state restores bump programChanges before they
+    // touch the parameters. The audio thread then fades the wet signal out
+    // on the settings it was already using, clears the delay lines, and
+    // fades back in on the new ones.
+    std::atomic<int> currentProgram { 0 };
+    std::atomic<uint32> programChanges { 0 };
+    uint32 programChangesSeen = 0;
+    int programFadeSamples = 0;
+    int programFadeRemaining = 0;
+    bool programSwitchPending = false;
+    ChorusSettings lastSettings;
+
+    /** Audio thread: the settings for this block, with any program change
+        crossfade applied.
+    */
+    template <typename SampleType>
+    ChorusSettings getBlockSettings (ChorusProcessor<SampleType>& chorus, int numSamples);
+
+   #if EZ_CHORUS_PERF_STATS
+    ChorusPerfStats perfStats;
+   #endif
 
-    
 public:
     //==============================================================================
     EZChorusAudioProcessor();
@@ -48,6 +89,11 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    juce::AudioProcessorParameter* getBypassParameter() const override     { return apvts.getParameter ("BYPASS"); }
+    bool supportsDoublePrecisionProcessing() const override     { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -71,10 +117,33 @@ public:
     //==============================================================================
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
-    float lerp (float sample1, float sample2, float inPhase);
     AudioProcessorValueTreeState apvts;
     AudioProcessorValueTreeState::ParameterLayout createParams();
+
+    /** Message thread: builds the DSP state for an oversampling factor raised
+        since prepareToPlay(). The timer calls it, so hosts don't need to; an
+        offline tool with no message loop can call it between blocks.
+    */
+    void prepareForOversampling();
+
+    /** Read from the message thread by the editor's scope and meters. */
+    ChorusTelemetry& getTelemetry()     { return telemetry; }
+
+    /** processBlock timings, or nullptr if EZ_CHORUS_PERF_STATS is 0. */
+    ChorusPerfStats* getPerfStats()
+    {
+       #if EZ_CHORUS_PERF_STATS
+        return &perfStats;
+       #else
+        return nullptr;
+       #endif
+    }
     
+private:
+    // Declared after apvts so the parameter pointers can be resolved from it.
+    ChorusParameterSnapshot parameters { apvts };
+    std::atomic<float>* bypassParameter = apvts.getRawParameterValue ("BYPASS");
+
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EZChorusAudioProcessor)
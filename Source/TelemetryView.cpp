@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    TelemetryView.cpp
+    LFO/delay scope and level meters fed from the processor's telemetry.
+
+  ==============================================================================
+*/
+
+#include "TelemetryView.h"
+
+//==============================================================================
+TelemetryView::TelemetryView (ChorusTelemetry& source, const ChorusPerfStats* stats)
+    : telemetry (source), perfStats (stats)
+{
+    setOpaque (false);
+    telemetry.addChangeListener (this);
+    startTimerHz (ChorusTelemetry::framesPerSecond);
+}
+
+TelemetryView::~TelemetryView()
+{
+    telemetry.removeChangeListener (this);
+}
+
+void TelemetryView::changeListenerCallback (ChangeBroadcaster*)
+{
+    if (! isTimerRunning())
+        startTimerHz (ChorusTelemetry::framesPerSecond);
+}
+
+void TelemetryView::timerCallback()
+{
+    const auto numFrames = telemetry.pull (incoming, ChorusTelemetry::capacity);
+
+    // Meters fall back at about 20 dB a second between peaks.
+    const float decay = 0.926f;
+    inputLevel *= decay;
+    wetLevel *= decay;
+    outputLevel *= decay;
+
+    // Nothing is being played: wait for the telemetry to report frames.
+    if (numFrames == 0 && inputLevel < 1.0e-4f && outputLevel < 1.0e-4f)
+    {
+        stopTimer();
+        return;
+    }
+
+    for (int i = 0; i < numFrames; i++)
+    {
+        const auto& frame = incoming[i];
+        numScopeTraces = jmin (numScopeChannels, frame.numChannels);
+
+        for (int ch = 0; ch < numScopeTraces; ch++)
+            lfoHistory[ch][historyWrite] = frame.lfo[ch];
+
+        historyWrite = (historyWrite + 1) % historyLength;
+
+        delayMs = frame.numChannels > 0 ? frame.delayMs[0] : 0.0f;
+        inputLevel = jmax (inputLevel, frame.inputPeak);
+        wetLevel = jmax (wetLevel, frame.wetPeak);
+        outputLevel = jmax (outputLevel, frame.outputPeak);
+    }
+
+    if (perfStats != nullptr)
+        perfSnapshot = perfStats->getSnapshot();
+
+    repaint();
+}
+
+void TelemetryView::paint (Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+
+    g.setColour (Colours::grey);
+    g.setOpacity (.5);
+    g.fillRoundedRectangle (bounds, 10);
+    g.setColour (Colours::white);
+    g.drawRoundedRectangle (bounds.reduced (1), 10, 2);
+
+    auto content = bounds.reduced (8);
+    auto meterArea = content.removeFromRight (66);
+    auto scopeArea = content.withTrimmedRight (6);
+
+    // LFO scope, oldest frame on the left.
+    const Colour traceColours[numScopeChannels] = { Colours::skyblue, Colours::white };
+    const auto step = scopeArea.getWidth() / (float) (historyLength - 1);
+
+    for (int ch = 0; ch < numScopeTraces; ch++)
+    {
+        Path trace;
+        for (int i = 0; i < historyLength; i++)
+        {
+            const auto value = lfoHistory[ch][(historyWrite + i) % historyLength];
+            const auto x = scopeArea.getX() + step * (float) i;
+            const auto y = jmap (value, -1.0f, 1.0f, scopeArea.getBottom(), scopeArea.getY());
+
+            if (i == 0)
+                trace.startNewSubPath (x, y);
+            else
+                trace.lineTo (x, y);
+        }
+
+        g.setColour (traceColours[ch]);
+        g.strokePath (trace, PathStrokeType (1.5f));
+    }
+
+    g.setFont (textFont);
+    g.setColour (Colours::white);
+    g.drawText (String (delayMs, 1) + " ms", scopeArea.removeFromTop (14), Justification::topLeft, false);
+
+    if (perfStats != nullptr)
+        g.drawText ("DSP " + String (perfSnapshot.averageLoad * 100.0, 1) + "%  peak " + String (perfSnapshot.peakLoad * 100.0, 1)
+                        + "%  overruns " + String ((int64) perfSnapshot.overruns),
+                    scopeArea.removeFromBottom (14), Justification::bottomLeft, false);
+
+    const auto meterWidth = meterArea.getWidth() / 3.0f;
+    drawMeter (g, meterArea.removeFromLeft (meterWidth), inputLevel, "IN");
+    drawMeter (g, meterArea.removeFromLeft (meterWidth), wetLevel, "WET");
+    drawMeter (g, meterArea, outputLevel, "OUT");
+}
+
+void TelemetryView::drawMeter (Graphics& g, Rectangle<float> area, float level, const String& name) const
+{
+    g.setColour (Colours::white);
+    g.drawText (name, area.removeFromBottom (14), Justification::centred, false);
+
+    auto bar = area.reduced (4, 0);
+    g.setColour (Colours::black);
+    g.fillRect (bar);
+
+    // -60 to 0 dB
+    const auto proportion = jlimit (0.0f, 1.0f, 1.0f + Decibels::gainToDecibels (level, -60.0f) / 60.0f);
+    g.setColour (level >= 1.0f ? Colours::red : Colours::skyblue);
+    g.fillRect (bar.removeFromBottom (bar.getHeight() * proportion));
+}
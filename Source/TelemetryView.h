@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    TelemetryView.h
+    LFO/delay scope and level meters fed from the processor's telemetry.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChorusTelemetry.h"
+#include "ChorusPerfStats.h"
+
+using namespace juce;
+
+//==============================================================================
+/**
+    Draws the last few seconds of the first two channels' LFOs, the current
+    delay time and input/wet/output peak meters, plus the processor's DSP
+    load and overrun count when it was built with EZ_CHORUS_PERF_STATS.
+
+    Frames are drained from the telemetry FIFO on a timer, and only this
+    component is repainted when they arrive. Once none have arrived and the
+    meters have fallen back, the timer stops until the telemetry reports
+    new frames.
+*/
+class TelemetryView  : public Component,
+                       private Timer,
+                       private ChangeListener
+{
+public:
+    /** perfStats may be nullptr. */
+    TelemetryView (ChorusTelemetry& source, const ChorusPerfStats* perfStats);
+    ~TelemetryView() override;
+
+    void paint (Graphics& g) override;
+
+private:
+    static constexpr int historyLength = 3 * ChorusTelemetry::framesPerSecond;
+    static constexpr int numScopeChannels = 2;
+
+    void timerCallback() override;
+    void changeListenerCallback (ChangeBroadcaster*) override;
+    void drawMeter (Graphics& g, Rectangle<float> area, float level, const String& name) const;
+
+    ChorusTelemetry& telemetry;
+    const ChorusPerfStats* perfStats;
+    ChorusPerfStats::Snapshot perfSnapshot;
+    ChorusTelemetry::Frame incoming[ChorusTelemetry::capacity];
+
+    float lfoHistory[numScopeChannels][historyLength] = {};
+    int historyWrite = 0;
+    int numScopeTraces = 0;
+
+    float delayMs = 0;
+    float inputLevel = 0;
+    float wetLevel = 0;
+    float outputLevel = 0;
+
+    Font textFont { 12.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TelemetryView)
+};
@@ -0,0 +1,566 @@
+/*
+  ==============================================================================
+
+    processBlock microbenchmark for EZ Chorus.
+
+    Times EZChorusAudioProcessor::processBlock over a grid of sample rates,
+    block sizes, parameter settings and interpolation qualities and writes
+    the results as JSON so runs from different commits can be diffed or
+    plotted.
+
+    Usage:
+        EZChorusBench [--out results.json] [--label name] [--seconds s]
+                      [--quality linear|hermite|lagrange|allpass] [--double] [--bypassed]
+                      [--bank tracks [--compact]] [--state]
+                      [--instances n [--editors]]
+
+        --double    run the AudioBuffer<double> processBlock instead of float
+        --bypassed  run the grid with the BYPASS parameter on, to time what a
+                    bypassed instance costs
+        --bank n    instead of the grid, time a ChorusBank of n stereo tracks
+                    with mixed settings at 1, 2, 4... threads, and check each
+                    track against its own EZChorusAudioProcessor, raising
+                    every track to 4x oversampling part way through; exits
+                    non-zero unless they match exactly and every track
+                    reached 4x
+        --compact   give the bank half-float delay lines; the difference from
+                    the float references is then their noise floor, which
+                    must stay below ChorusStateBase::halfStorageNoiseDb
+        --state     instead of the grid, time setStateInformation with the
+                    binary state and with the older XML one
+        --instances n
+                    instead of the grid, create n prepared plugin instances
+                    and report the time and resident memory the first one
+                    and each later one costs
+        --editors   give every instance an open, painted editor as well
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+#include "../../../Source/ChorusBank.h"
+
+#if JUCE_LINUX
+ #include <unistd.h>
+#elif JUCE_MAC
+ #include <mach/mach.h>
+#elif JUCE_WINDOWS
+ #include <windows.h>
+ #include <psapi.h>
+ #pragma comment (lib, "psapi.lib")
+#endif
+
+using namespace juce;
+
+//==============================================================================
+struct ParameterSet
+{
+    const char* name;
+    float feedback, phaseOffset, mix, depth, rate;
+    int voices;
+    int oversampling;
+    int economy;
+};
+
+static const ParameterSet parameterSets[] =
+{
+    { "default",          0.35f, 0.2f,  0.5f, 0.35f, 0.2f, 1, 1, 1 },
+    { "high-feedback",    0.98f, 0.2f,  0.5f, 0.35f, 0.2f, 1, 1, 1 },
+    { "deep-fast",        0.5f,  0.5f,  0.5f, 1.0f,  5.0f, 1, 1, 1 },
+    { "wide-offset",      0.35f, 1.0f,  1.0f, 0.6f,  1.0f, 1, 1, 1 },
+    { "static",           0.0f,  0.0f,  0.5f, 0.0f,  0.0f, 1, 1, 1 },
+    { "four-voices",      0.35f, 0.2f,  0.5f, 0.35f, 0.2f, 4, 1, 1 },
+    { "eight-voices",     0.35f, 0.2f,  0.5f, 0.35f, 0.2f, 8, 1, 1 },
+    { "oversampled-2x",   0.35f, 0.2f,  0.5f, 0.35f, 0.2f, 1, 2, 1 },
+    { "oversampled-4x",   0.35f, 0.2f,  0.5f, 0.35f, 0.2f, 1, 4, 1 },
+    { "high-feedback-4x", 0.98f, 0.2f,  0.5f, 0.35f, 0.2f, 1, 4, 1 },
+    { "economy-half",     0.35f, 0.2f,  0.5f, 0.35f, 0.2f, 1, 1, 2 },
+    { "economy-quarter",  0.35f, 0.2f,  0.5f, 0.35f, 0.2f, 1, 1, 4 },
+    { "economy-8-voices", 0.35f, 0.2f,  0.5f, 0.35f, 0.2f, 8, 1, 2 },
+};
+
+static const double sampleRates[] = { 44100.0, 48000.0, 96000.0, 192000.0 };
+
+// In the order of the QUALITY parameter's choices.
+static const StringArray qualityNames { "linear", "hermite", "lagrange", "allpass" };
+
+//==============================================================================
+static void setParameter (EZChorusAudioProcessor& processor, const String& id, float value)
+{
+    if (auto* param = processor.apvts.getParameter (id))
+        param->setValueNotifyingHost (param->convertTo0to1 (value));
+}
+
+static void applyParameterSet (EZChorusAudioProcessor& processor, const ParameterSet& set)
+{
+    setParameter (processor, "FEEDBACK", set.feedback);
+    setParameter (processor, "PHASEOFFSET", set.phaseOffset);
+    setParameter (processor, "MIX", set.mix);
+    setParameter (processor, "CHORUSDEPTH", set.depth);
+    setParameter (processor, "CHORUSRATE", set.rate);
+    setParameter (processor, "VOICES", (float) (set.voices - 1));
+    setParameter (processor, "OVERSAMPLING", std::log2 ((float) set.oversampling));
+    setParameter (processor, "ECONOMY", std::log2 ((float) set.economy));
+}
+
+static double percentile (const Array<double>& sorted, double fraction)
+{
+    const auto index = jlimit (0, sorted.size() - 1, roundToInt (fraction * (sorted.size() - 1)));
+    return sorted.getUnchecked (index);
+}
+
+template <typename SampleType>
+static var runCase (const ParameterSet& set, int quality, double sampleRate, int blockSize, double secondsOfAudio,
+                    bool bypassed)
+{
+    constexpr auto isDouble = std::is_same_v<SampleType, double>;
+
+    EZChorusAudioProcessor processor;
+    const auto numChannels = processor.getTotalNumOutputChannels();
+    processor.setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+    processor.setProcessingPrecision (isDouble ? AudioProcessor::doublePrecision : AudioProcessor::singlePrecision);
+    applyParameterSet (processor, set);
+    setParameter (processor, "QUALITY", (float) quality);
+    setParameter (processor, "BYPASS", bypassed ? 1.0f : 0.0f);
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    // A fixed-seed noise source so every run sees the same input.
+    AudioBuffer<SampleType> source (numChannels, blockSize * 16);
+    Random random (0x5eed);
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < source.getNumSamples(); ++i)
+            source.setSample (ch, i, (SampleType) ((random.nextFloat() * 2.0f - 1.0f) * 0.25f));
+
+    AudioBuffer<SampleType> buffer (numChannels, blockSize);
+    MidiBuffer midi;
+
+    const auto numBlocks = jmax (64, (int) (secondsOfAudio * sampleRate / blockSize));
+    const auto numWarmupBlocks = jmax (8, numBlocks / 10);
+    Array<double> blockNanos;
+    blockNanos.ensureStorageAllocated (numBlocks);
+
+    const auto ticksToNanos = 1.0e9 / (double) Time::getHighResolutionTicksPerSecond();
+
+    for (int block = 0; block < numWarmupBlocks + numBlocks; ++block)
+    {
+        const auto sourceOffset = (block % 16) * blockSize;
+        for (int ch = 0; ch < numChannels; ++ch)
+            buffer.copyFrom (ch, 0, source, ch, sourceOffset, blockSize);
+
+        const auto start = Time::getHighResolutionTicks();
+        processor.processBlock (buffer, midi);
+        const auto end = Time::getHighResolutionTicks();
+
+        if (block >= numWarmupBlocks)
+            blockNanos.add ((double) (end - start) * ticksToNanos);
+    }
+
+    // The processor's own view of the same run, when it was built with
+    // EZ_CHORUS_PERF_STATS: its histogram and overrun count.
+    var processorStats;
+    if (auto* stats = processor.getPerfStats())
+        processorStats = stats->toVar();
+
+    processor.releaseResources();
+
+    double totalNanos = 0;
+    for (auto n : blockNanos)
+        totalNanos += n;
+
+    blockNanos.sort();
+
+    const auto totalSamples = (double) numBlocks * blockSize;
+    const auto blockBudgetNanos = 1.0e9 * blockSize / sampleRate;
+
+    auto* result = new DynamicObject();
+    result->setProperty ("parameters", String (set.name));
+    result->setProperty ("quality", qualityNames[quality]);
+    result->setProperty ("precision", isDouble ? "double" : "float");
+    result->setProperty ("bypassed", bypassed);
+    result->setProperty ("oversampling", set.oversampling);
+    result->setProperty ("economy", set.economy);
+    result->setProperty ("latencySamples", processor.getLatencySamples());
+    result->setProperty ("sampleRate", sampleRate);
+    result->setProperty ("blockSize", blockSize);
+    result->setProperty ("channels", numChannels);
+    result->setProperty ("blocks", numBlocks);
+    result->setProperty ("nsPerSample", totalNanos / totalSamples);
+    result->setProperty ("realtimeFactor", blockBudgetNanos * numBlocks / totalNanos);
+    result->setProperty ("blockNsP50", percentile (blockNanos, 0.5));
+    result->setProperty ("blockNsP90", percentile (blockNanos, 0.9));
+    result->setProperty ("blockNsP99", percentile (blockNanos, 0.99));
+    result->setProperty ("blockNsMax", blockNanos.getLast());
+    if (! processorStats.isVoid())
+        result->setProperty ("processorStats", processorStats);
+    return var (result);
+}
+
+//==============================================================================
+/** Times a bank of numTracks stereo tracks, each track using the next
+    parameter set, and compares every track with a plugin instance fed the
+    same input. Part way through every track is switched to 4x oversampling,
+    which most of them weren't prepared for, so the bank has to build their
+    bigger states the way the plugin does.
+*/
+static var runBank (int numTracks, int numThreads, double sampleRate, int blockSize, double secondsOfAudio,
+                    DelayStorage storage)
+{
+    const int numChannels = 2;
+    const auto numBlocks = jmax (16, (int) (secondsOfAudio * sampleRate / blockSize));
+    const int numComparedBlocks = 32, raiseOversamplingBlock = 8, raisedOversampling = 4;
+
+    ChorusBank<float> bank (numTracks);
+    OwnedArray<EZChorusAudioProcessor> references;
+    OwnedArray<AudioBuffer<float>> trackBuffers, referenceBuffers;
+    Array<dsp::AudioBlock<float>> blocks;
+
+    for (int t = 0; t < numTracks; ++t)
+    {
+        auto* reference = references.add (new EZChorusAudioProcessor());
+        reference->setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+        applyParameterSet (*reference, parameterSets[t % numElementsInArray (parameterSets)]);
+        reference->prepareToPlay (sampleRate, blockSize);
+
+        // The settings exactly as the plugin sees them after the parameter
+        // ranges have snapped them.
+        bank.setSettings (t, ChorusParameterSnapshot (reference->apvts).get());
+
+        auto* buffer = trackBuffers.add (new AudioBuffer<float> (numChannels, blockSize));
+        blocks.add (dsp::AudioBlock<float> (*buffer));
+        referenceBuffers.add (new AudioBuffer<float> (numChannels, blockSize));
+    }
+
+    bank.prepare ({ sampleRate, (uint32) blockSize, (uint32) numChannels }, numThreads, storage);
+
+    MidiBuffer midi;
+    Random random (0x5eed);
+    double totalNanos = 0;
+    float maxDifference = 0;
+    double differenceEnergy = 0, referenceEnergy = 0;
+    const auto ticksToNanos = 1.0e9 / (double) Time::getHighResolutionTicksPerSecond();
+
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        for (auto* buffer : trackBuffers)
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer->setSample (ch, i, (random.nextFloat() * 2.0f - 1.0f) * 0.25f);
+
+        if (block == raiseOversamplingBlock)
+        {
+            for (int t = 0; t < numTracks; ++t)
+            {
+                setParameter (*references[t], "OVERSAMPLING", std::log2 ((float) raisedOversampling));
+                bank.setSettings (t, ChorusParameterSnapshot (references[t]->apvts).get());
+            }
+        }
+
+        // The references only run over the first few blocks; after that the
+        // bank runs alone.
+        const bool compare = block < numComparedBlocks;
+        if (compare)
+        {
+            for (int t = 0; t < numTracks; ++t)
+            {
+                referenceBuffers[t]->makeCopyOf (*trackBuffers[t], true);
+                references[t]->processBlock (*referenceBuffers[t], midi);
+            }
+        }
+
+        const auto start = Time::getHighResolutionTicks();
+        bank.process (blocks.getRawDataPointer());
+        totalNanos += (double) (Time::getHighResolutionTicks() - start) * ticksToNanos;
+
+        if (compare)
+            for (int t = 0; t < numTracks; ++t)
+                for (int ch = 0; ch < numChannels; ++ch)
+                    for (int i = 0; i < blockSize; ++i)
+                    {
+                        const auto expected = referenceBuffers[t]->getSample (ch, i);
+                        const auto difference = trackBuffers[t]->getSample (ch, i) - expected;
+                        maxDifference = jmax (maxDifference, std::abs (difference));
+                        differenceEnergy += (double) difference * difference;
+                        referenceEnergy += (double) expected * expected;
+                    }
+
+        // What the plugin's timer does, at the same point for both.
+        bank.prepareForOversampling();
+
+        if (compare)
+            for (auto* reference : references)
+                reference->prepareForOversampling();
+    }
+
+    // Matching the plugin isn't enough if both stayed at the prepared factor.
+    int tracksNotRaised = 0;
+    for (int t = 0; t < numTracks; ++t)
+        if (bank.getLatencySamples (t) != ChorusStateBase::getOversamplingLatency (raisedOversampling))
+            ++tracksNotRaised;
+
+    auto* result = new DynamicObject();
+    result->setProperty ("tracks", numTracks);
+    result->setProperty ("threads", numThreads);
+    result->setProperty ("sampleRate", sampleRate);
+    result->setProperty ("blockSize", blockSize);
+    result->setProperty ("blocks", numBlocks);
+    result->setProperty ("nsPerTrackSample", totalNanos / ((double) numBlocks * blockSize * numTracks));
+    result->setProperty ("realtimeFactor", 1.0e9 * blockSize * numBlocks / sampleRate / totalNanos);
+    result->setProperty ("storage", storage == DelayStorage::half ? "half" : "full");
+    // Full storage runs exactly the plugin's code, so anything but an exact
+    // match is a bug. Half floats only have to stay below their noise bound.
+    const auto differenceDb = Decibels::gainToDecibels (std::sqrt (differenceEnergy / jmax (referenceEnergy, 1.0e-30)), -200.0);
+    const auto matches = storage == DelayStorage::half ? differenceDb <= ChorusStateBase::halfStorageNoiseDb
+                                                       : maxDifference == 0.0f;
+
+    result->setProperty ("maxDifference", maxDifference);
+    result->setProperty ("differenceDb", differenceDb);
+    result->setProperty ("tracksNotRaised", tracksNotRaised);
+    result->setProperty ("matches", matches);
+    return var (result);
+}
+
+//==============================================================================
+/** Times restoring the same parameter values from the binary state and
+    from an XML state of the kind older builds saved, as a host does for
+    every instance when it opens a session.
+*/
+static var runStateRestore (int numRestores)
+{
+    EZChorusAudioProcessor processor;
+    applyParameterSet (processor, parameterSets[1]);
+
+    MemoryBlock binaryState, xmlState;
+    processor.getStateInformation (binaryState);
+
+    if (auto xml = processor.apvts.copyState().createXml())
+        AudioProcessor::copyXmlToBinary (*xml, xmlState);
+
+    const auto timeRestores = [&processor, numRestores] (const MemoryBlock& state)
+    {
+        const auto start = Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numRestores; ++i)
+            processor.setStateInformation (state.getData(), (int) state.getSize());
+
+        return Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start) * 1.0e6 / numRestores;
+    };
+
+    auto* result = new DynamicObject();
+    result->setProperty ("restores", numRestores);
+    result->setProperty ("binaryBytes", (int) binaryState.getSize());
+    result->setProperty ("xmlBytes", (int) xmlState.getSize());
+    result->setProperty ("binaryMicroseconds", timeRestores (binaryState));
+    result->setProperty ("xmlMicroseconds", timeRestores (xmlState));
+    return var (result);
+}
+
+//==============================================================================
+/** The process's resident memory, or 0 where it can't be read. */
+static int64 getResidentBytes()
+{
+   #if JUCE_LINUX
+    const auto fields = StringArray::fromTokens (File ("/proc/self/statm").loadFileAsString(), false);
+    return fields[1].getLargeIntValue() * (int64) sysconf (_SC_PAGESIZE);
+   #elif JUCE_MAC
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info (mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) == KERN_SUCCESS)
+        return (int64) info.resident_size;
+    return 0;
+   #elif JUCE_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo (GetCurrentProcess(), &counters, sizeof (counters)))
+        return (int64) counters.WorkingSetSize;
+    return 0;
+   #else
+    return 0;
+   #endif
+}
+
+/** Creates numInstances stereo instances as a host loading a session
+    would: construct, prepareToPlay, one block and, optionally, an editor
+    that is painted once. The first instance pays for anything shared
+    between instances; the later ones show what each extra one costs.
+*/
+static var runInstances (int numInstances, bool withEditors)
+{
+    const double sampleRate = 48000.0;
+    const int blockSize = 512;
+
+    OwnedArray<EZChorusAudioProcessor> processors;
+    OwnedArray<AudioProcessorEditor> editors;
+    AudioBuffer<float> buffer (2, blockSize);
+    MidiBuffer midi;
+    Array<double> millis;
+
+    const auto bytesBefore = getResidentBytes();
+    int64 bytesAfterFirst = 0;
+
+    for (int i = 0; i < numInstances; ++i)
+    {
+        const auto start = Time::getHighResolutionTicks();
+
+        auto* processor = processors.add (new EZChorusAudioProcessor());
+        processor->setPlayConfigDetails (2, 2, sampleRate, blockSize);
+        processor->prepareToPlay (sampleRate, blockSize);
+        buffer.clear();
+        processor->processBlock (buffer, midi);
+
+        if (withEditors)
+        {
+            auto* editor = editors.add (processor->createEditor());
+            editor->createComponentSnapshot (editor->getLocalBounds());
+        }
+
+        millis.add (Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start) * 1000.0);
+
+        if (i == 0)
+            bytesAfterFirst = getResidentBytes();
+    }
+
+    const auto bytesAfter = getResidentBytes();
+    const auto numLater = jmax (1, numInstances - 1);
+
+    double laterMillis = 0;
+    for (int i = 1; i < millis.size(); ++i)
+        laterMillis += millis[i];
+
+    editors.clear();
+    processors.clear();
+
+    auto* result = new DynamicObject();
+    result->setProperty ("instances", numInstances);
+    result->setProperty ("editors", withEditors);
+    result->setProperty ("firstInstanceMs", millis[0]);
+    result->setProperty ("laterInstanceMs", laterMillis / numLater);
+    result->setProperty ("firstInstanceBytes", bytesAfterFirst - bytesBefore);
+    result->setProperty ("laterInstanceBytes", (double) (bytesAfter - bytesAfterFirst) / numLater);
+    return var (result);
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    File outputFile;
+    String label = "unnamed";
+    double secondsOfAudio = 2.0;
+    Array<int> qualities { 0, 1, 2, 3 };
+    bool useDouble = false;
+    bool bypassed = false;
+    int bankTracks = 0;
+    auto bankStorage = DelayStorage::full;
+    bool timeStateRestore = false;
+    int numInstances = 0;
+    bool withEditors = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const String arg (argv[i]);
+        const auto hasValue = i + 1 < argc;
+
+        if (arg == "--out" && hasValue)
+            outputFile = File::getCurrentWorkingDirectory().getChildFile (argv[++i]);
+        else if (arg == "--label" && hasValue)
+            label = argv[++i];
+        else if (arg == "--seconds" && hasValue)
+            secondsOfAudio = jmax (0.1, String (argv[++i]).getDoubleValue());
+        else if (arg == "--quality" && hasValue && qualityNames.contains (argv[i + 1]))
+            qualities = { qualityNames.indexOf (argv[++i]) };
+        else if (arg == "--double")
+            useDouble = true;
+        else if (arg == "--bypassed")
+            bypassed = true;
+        else if (arg == "--bank" && hasValue)
+            bankTracks = jmax (1, String (argv[++i]).getIntValue());
+        else if (arg == "--compact")
+            bankStorage = DelayStorage::half;
+        else if (arg == "--state")
+            timeStateRestore = true;
+        else if (arg == "--instances" && hasValue)
+            numInstances = jmax (1, String (argv[++i]).getIntValue());
+        else if (arg == "--editors")
+            withEditors = true;
+        else
+        {
+            std::cout << "Usage: EZChorusBench [--out results.json] [--label name] [--seconds s]"
+                      << " [--quality linear|hermite|lagrange|allpass] [--double] [--bypassed] [--bank tracks [--compact]] [--state]"
+                      << " [--instances n [--editors]]" << std::endl;
+            return 1;
+        }
+    }
+
+    Array<var> results;
+    bool passed = true;
+
+    if (bankTracks > 0)
+    {
+        for (int numThreads = 1; numThreads <= SystemStats::getNumCpus(); numThreads *= 2)
+        {
+            auto result = runBank (bankTracks, numThreads, 48000.0, 512, secondsOfAudio, bankStorage);
+            std::cerr << bankTracks << " tracks, " << numThreads << " threads: "
+                      << String ((double) result["realtimeFactor"], 1) << "x realtime, max difference "
+                      << (float) result["maxDifference"] << " (" << String ((double) result["differenceDb"], 1)
+                      << " dB rms)" << ((bool) result["matches"] ? "" : " FAIL: bank differs from the plugin") << std::endl;
+            if ((int) result["tracksNotRaised"] > 0)
+                std::cerr << "FAIL: " << (int) result["tracksNotRaised"] << " tracks stayed at their prepared oversampling factor" << std::endl;
+            passed &= (bool) result["matches"] && (int) result["tracksNotRaised"] == 0;
+            results.add (result);
+        }
+
+        // The bank run replaces the grid.
+        qualities.clear();
+    }
+
+    if (timeStateRestore)
+    {
+        auto result = runStateRestore (1000);
+        std::cerr << "state restore: binary " << String ((double) result["binaryMicroseconds"], 1) << " us ("
+                  << (int) result["binaryBytes"] << " bytes), XML " << String ((double) result["xmlMicroseconds"], 1)
+                  << " us (" << (int) result["xmlBytes"] << " bytes)" << std::endl;
+        results.add (result);
+        qualities.clear();
+    }
+
+    if (numInstances > 0)
+    {
+        auto result = runInstances (numInstances, withEditors);
+        std::cerr << numInstances << (withEditors ? " instances with editors: " : " instances: ")
+                  << "first " << String ((double) result["firstInstanceMs"], 2) << " ms, "
+                  << String ((double) (int64) result["firstInstanceBytes"] / 1024.0, 0) << " KB; each later one "
+                  << String ((double) result["laterInstanceMs"], 2) << " ms, "
+                  << String ((double) result["laterInstanceBytes"] / 1024.0, 0) << " KB" << std::endl;
+        results.add (result);
+        qualities.clear();
+    }
+
+    for (auto quality : qualities)
+        for (auto& set : parameterSets)
+            for (auto sampleRate : sampleRates)
+                for (int blockSize = 16; blockSize <= 4096; blockSize *= 2)
+                {
+                    auto result = useDouble ? runCase<double> (set, quality, sampleRate, blockSize, secondsOfAudio, bypassed)
+                                            : runCase<float> (set, quality, sampleRate, blockSize, secondsOfAudio, bypassed);
+                    std::cerr << qualityNames[quality] << " " << set.name << " " << sampleRate << " Hz, " << blockSize << " samples: "
+                              << String ((double) result["nsPerSample"], 2) << " ns/sample" << std::endl;
+                    results.add (result);
+                }
+
+    auto* run = new DynamicObject();
+    run->setProperty ("label", label);
+    run->setProperty ("date", Time::getCurrentTime().toISO8601 (true));
+    run->setProperty ("cpu", SystemStats::getCpuModel());
+    run->setProperty ("juceVersion", SystemStats::getJUCEVersion());
+    run->setProperty ("results", results);
+
+    const auto json = JSON::toString (var (run));
+
+    if (outputFile != File())
+        outputFile.replaceWithText (json);
+    else
+        std::cout << json << std::endl;
+
+    return passed ? 0 : 1;
+}
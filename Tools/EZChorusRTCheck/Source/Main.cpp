@@ -0,0 +1,498 @@
+/*
+  ==============================================================================
+
+    Realtime-safety check for EZ Chorus.
+
+    Drives EZChorusAudioProcessor through prepareToPlay, parameter changes,
+    state restores and thousands of blocks, in both float and double
+    precision, with every processBlock call audited for heap allocation,
+    deallocation and blocking calls. A ChorusProcessor is also re-prepared
+    from a second thread while blocks are processing, as a host's message
+    thread would. It also checks that a saved state brings back every
+    parameter, bypass included. Exits with a non-zero status if any
+    violations or unrestored parameters are seen, so it can gate a build.
+
+    The global operator new/delete family, including the aligned forms, is
+    replaced on every platform. On
+    Linux malloc/calloc/realloc/free and pthread_mutex_lock/pthread_cond_wait
+    are interposed as well, which also catches allocations and locks made by
+    JUCE and the C++ runtime on the processor's behalf.
+
+    Usage:
+        EZChorusRTCheck [--blocks n] [--abort]
+
+        --blocks <n>    blocks per scenario (default 2000)
+        --abort         abort() on the first violation, for a debugger
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <pthread.h>
+#endif
+
+using namespace juce;
+
+//==============================================================================
+namespace RealtimeAudit
+{
+    enum Kind
+    {
+        allocation,
+        deallocation,
+        blockingCall,
+        numKinds
+    };
+
+    static thread_local bool auditing = false;
+    static std::atomic<int> violations[numKinds] {};
+    static bool abortOnViolation = false;
+
+    static void note (Kind kind)
+    {
+        if (! auditing)
+            return;
+
+        violations[kind].fetch_add (1, std::memory_order_relaxed);
+
+        if (abortOnViolation)
+            std::abort();
+    }
+
+    static int total()
+    {
+        int sum = 0;
+        for (auto& count : violations)
+            sum += count.load();
+
+        return sum;
+    }
+
+    /** Marks the calling thread as the audio thread for its lifetime. */
+    struct ScopedAudit
+    {
+        ScopedAudit()   { auditing = true; }
+        ~ScopedAudit()  { auditing = false; }
+    };
+}
+
+//==============================================================================
+#if JUCE_LINUX
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+    void __libc_free (void*);
+
+    void* malloc (size_t size)                      { RealtimeAudit::note (RealtimeAudit::allocation); return __libc_malloc (size); }
+    void* calloc (size_t n, size_t size)            { RealtimeAudit::note (RealtimeAudit::allocation); return __libc_calloc (n, size); }
+    void* realloc (void* p, size_t size)            { RealtimeAudit::note (RealtimeAudit::allocation); return __libc_realloc (p, size); }
+    void* memalign (size_t align, size_t size)      { RealtimeAudit::note (RealtimeAudit::allocation); return __libc_memalign (align, size); }
+    void* aligned_alloc (size_t align, size_t size) { RealtimeAudit::note (RealtimeAudit::allocation); return __libc_memalign (align, size); }
+
+    int posix_memalign (void** result, size_t align, size_t size)
+    {
+        RealtimeAudit::note (RealtimeAudit::allocation);
+        *result = __libc_memalign (align, size);
+        return *result != nullptr ? 0 : ENOMEM;
+    }
+
+    void free (void* p)
+    {
+        if (p != nullptr)
+            RealtimeAudit::note (RealtimeAudit::deallocation);
+
+        __libc_free (p);
+    }
+
+    // Resolved before main() so the hooks never need a guarded static.
+    static int (*realMutexLock) (pthread_mutex_t*) = nullptr;
+    static int (*realCondWait) (pthread_cond_t*, pthread_mutex_t*) = nullptr;
+
+    __attribute__((constructor)) static void resolveLockFunctions()
+    {
+        realMutexLock = (int (*) (pthread_mutex_t*)) dlsym (RTLD_NEXT, "pthread_mutex_lock");
+        realCondWait = (int (*) (pthread_cond_t*, pthread_mutex_t*)) dlsym (RTLD_NEXT, "pthread_cond_wait");
+    }
+
+    int pthread_mutex_lock (pthread_mutex_t* mutex)
+    {
+        RealtimeAudit::note (RealtimeAudit::blockingCall);
+        return realMutexLock (mutex);
+    }
+
+    int pthread_cond_wait (pthread_cond_t* condition, pthread_mutex_t* mutex)
+    {
+        RealtimeAudit::note (RealtimeAudit::blockingCall);
+        return realCondWait (condition, mutex);
+    }
+}
+
+static void* rawAllocate (size_t size)                      { return __libc_malloc (size); }
+static void* rawAllocateAligned (size_t size, size_t align) { return __libc_memalign (align, size); }
+static void rawFree (void* p)                               { __libc_free (p); }
+static void rawFreeAligned (void* p)                        { __libc_free (p); }
+#elif JUCE_WINDOWS
+static void* rawAllocate (size_t size)                      { return std::malloc (size); }
+static void* rawAllocateAligned (size_t size, size_t align) { return _aligned_malloc (size, align); }
+static void rawFree (void* p)                               { std::free (p); }
+static void rawFreeAligned (void* p)                        { _aligned_free (p); }
+#else
+static void* rawAllocate (size_t size)                      { return std::malloc (size); }
+static void rawFree (void* p)                               { std::free (p); }
+static void rawFreeAligned (void* p)                        { std::free (p); }
+
+static void* rawAllocateAligned (size_t size, size_t align)
+{
+    void* p = nullptr;
+    return posix_memalign (&p, jmax (align, sizeof (void*)), size) == 0 ? p : nullptr;
+}
+#endif
+
+//==============================================================================
+void* operator new (size_t size)
+{
+    RealtimeAudit::note (RealtimeAudit::allocation);
+    if (auto* p = rawAllocate (size > 0 ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (size_t size)                                  { return operator new (size); }
+void* operator new (size_t size, const std::nothrow_t&) noexcept    { RealtimeAudit::note (RealtimeAudit::allocation); return rawAllocate (size > 0 ? size : 1); }
+void* operator new[] (size_t size, const std::nothrow_t&) noexcept  { return operator new (size, std::nothrow); }
+
+void operator delete (void* p) noexcept
+{
+    if (p != nullptr)
+        RealtimeAudit::note (RealtimeAudit::deallocation);
+
+    rawFree (p);
+}
+
+void operator delete[] (void* p) noexcept                           { operator delete (p); }
+void operator delete (void* p, size_t) noexcept                     { operator delete (p); }
+void operator delete[] (void* p, size_t) noexcept                   { operator delete (p); }
+
+// Over-aligned types (alignas above the default) go through these.
+void* operator new (size_t size, std::align_val_t align)
+{
+    RealtimeAudit::note (RealtimeAudit::allocation);
+    if (auto* p = rawAllocateAligned (size > 0 ? size : 1, (size_t) align))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (size_t size, std::align_val_t align)                                  { return operator new (size, align); }
+void* operator new (size_t size, std::align_val_t align, const std::nothrow_t&) noexcept    { RealtimeAudit::note (RealtimeAudit::allocation); return rawAllocateAligned (size > 0 ? size : 1, (size_t) align); }
+void* operator new[] (size_t size, std::align_val_t align, const std::nothrow_t&) noexcept  { return operator new (size, align, std::nothrow); }
+
+void operator delete (void* p, std::align_val_t) noexcept
+{
+    if (p != nullptr)
+        RealtimeAudit::note (RealtimeAudit::deallocation);
+
+    rawFreeAligned (p);
+}
+
+void operator delete[] (void* p, std::align_val_t align) noexcept           { operator delete (p, align); }
+void operator delete (void* p, size_t, std::align_val_t align) noexcept     { operator delete (p, align); }
+void operator delete[] (void* p, size_t, std::align_val_t align) noexcept   { operator delete (p, align); }
+
+//==============================================================================
+/** Stands in for a host wrapper, so notifications sent from the audio thread
+    go through the same listener locking a real host would see.
+*/
+struct HostListener  : public AudioProcessorListener
+{
+    void audioProcessorParameterChanged (AudioProcessor*, int, float) override {}
+    void audioProcessorChanged (AudioProcessor*, const ChangeDetails&) override {}
+};
+
+static void setParameter (EZChorusAudioProcessor& processor, const String& id, float value)
+{
+    if (auto* param = processor.apvts.getParameter (id))
+        param->setValueNotifyingHost (param->convertTo0to1 (value));
+}
+
+static bool report (const String& name, int found, const char* what = "violations")
+{
+    std::cout << (found == 0 ? "PASS  " : "FAIL  ") << name;
+    if (found > 0)
+        std::cout << " (" << found << " " << what << ")";
+    std::cout << std::endl;
+
+    return found == 0;
+}
+
+template <typename SampleType>
+static bool runScenario (const String& name, EZChorusAudioProcessor& processor, AudioBuffer<SampleType>& buffer,
+                         int numBlocks, const std::function<void (int)>& betweenBlocks)
+{
+    MidiBuffer midi;
+    Random random (0x5eed);
+    const auto before = RealtimeAudit::total();
+
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        // Parameter changes and state restores happen on the "message
+        // thread", outside the audited region, as they would in a host.
+        betweenBlocks (block);
+
+        // Alternate bursts of noise with stretches of silence so the idle
+        // path and the wake-up from it are exercised too.
+        const bool silent = (block / 200) % 3 == 2;
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample (ch, i, silent ? SampleType() : (SampleType) ((random.nextFloat() * 2.0f - 1.0f) * 0.25f));
+
+        RealtimeAudit::ScopedAudit audit;
+        processor.processBlock (buffer, midi);
+    }
+
+    const auto found = RealtimeAudit::total() - before;
+    return report (name, found);
+}
+
+/** Saves the state with bypass on, moves every parameter to its default,
+    restores the state and checks that each one came back.
+*/
+static bool checkStateRoundTrip (const String& name, EZChorusAudioProcessor& processor)
+{
+    setParameter (processor, "BYPASS", 1.0f);
+
+    float saved[ChorusPresets::numParameters];
+    for (int i = 0; i < ChorusPresets::numParameters; ++i)
+        saved[i] = processor.apvts.getRawParameterValue (ChorusPresets::parameterIDs[i])->load();
+
+    MemoryBlock state;
+    processor.getStateInformation (state);
+
+    for (auto* id : ChorusPresets::parameterIDs)
+        if (auto* param = processor.apvts.getParameter (id))
+            param->setValueNotifyingHost (param->getDefaultValue());
+
+    processor.setStateInformation (state.getData(), (int) state.getSize());
+
+    // Every parameter's step is at least 0.001, so anything closer is the same value.
+    int numMismatches = 0;
+    for (int i = 0; i < ChorusPresets::numParameters; ++i)
+        if (std::abs (processor.apvts.getRawParameterValue (ChorusPresets::parameterIDs[i])->load() - saved[i]) > 1.0e-4f)
+            ++numMismatches;
+
+    return report (name, numMismatches, "parameters not restored");
+}
+
+template <typename SampleType>
+static bool runProcessor (int numChannels, int blockSize, int numBlocks, AudioProcessorListener& hostListener)
+{
+    constexpr auto isDouble = std::is_same_v<SampleType, double>;
+
+    EZChorusAudioProcessor processor;
+    processor.addListener (&hostListener);
+    processor.setPlayConfigDetails (numChannels, numChannels, 48000.0, blockSize);
+    processor.setProcessingPrecision (isDouble ? AudioProcessor::doublePrecision : AudioProcessor::singlePrecision);
+    processor.prepareToPlay (48000.0, blockSize);
+
+    AudioBuffer<SampleType> buffer (numChannels, blockSize);
+    const auto prefix = String (isDouble ? "double, " : "float, ") + String (numChannels) + " ch, " + String (blockSize) + " samples: ";
+    bool passed = true;
+
+    passed &= runScenario (prefix + "steady", processor, buffer, numBlocks, [] (int) {});
+
+    // Sweep every parameter, including the ones that switch kernels,
+    // change the oversampling or economy factor and re-layout the voices.
+    passed &= runScenario (prefix + "parameter changes", processor, buffer, numBlocks, [&processor] (int block)
+    {
+        if (block % 50 != 0)
+            return;
+
+        const auto step = block / 50;
+        setParameter (processor, "MIX", (float) (step % 11) / 10.0f);
+        setParameter (processor, "FEEDBACK", (float) (step % 7) * 0.14f);
+        setParameter (processor, "CHORUSDEPTH", (float) (step % 5) / 4.0f);
+        setParameter (processor, "CHORUSRATE", (float) (step % 6));
+        setParameter (processor, "PHASEOFFSET", (float) (step % 3) / 2.0f);
+        setParameter (processor, "LFOSHAPE", (float) (step % 3));
+        setParameter (processor, "VOICES", (float) (step % 8));
+        setParameter (processor, "VOICESPREAD", (float) (step % 4) / 3.0f);
+        setParameter (processor, "QUALITY", (float) (step % 4));
+        setParameter (processor, "OVERSAMPLING", (float) (step % 3));
+        setParameter (processor, "ECONOMY", (float) ((step / 3) % 3));
+    });
+
+    MemoryBlock savedState;
+    processor.getStateInformation (savedState);
+
+    passed &= runScenario (prefix + "state restore", processor, buffer, numBlocks, [&processor, &savedState] (int block)
+    {
+        if (block % 100 == 0)
+            processor.setStateInformation (savedState.getData(), (int) savedState.getSize());
+    });
+
+    // Preset changes, which crossfade and clear the delay lines on the
+    // audio thread, sometimes landing mid-fade.
+    passed &= runScenario (prefix + "program changes", processor, buffer, numBlocks, [&processor] (int block)
+    {
+        if (block % 40 == 0 || block % 40 == 1)
+            processor.setCurrentProgram ((block / 40 + block % 40) % processor.getNumPrograms());
+    });
+
+    // A short bypass that re-enables mid-tail, then one long enough for the
+    // tail to die away and the fully bypassed path to run.
+    passed &= runScenario (prefix + "bypass", processor, buffer, numBlocks, [&processor] (int block)
+    {
+        if (block == 0)
+            setParameter (processor, "FEEDBACK", 0.35f);
+
+        const auto phase = block % 600;
+        if (phase == 0 || phase == 100)
+            setParameter (processor, "BYPASS", 1.0f);
+        else if (phase == 20 || phase == 500)
+            setParameter (processor, "BYPASS", 0.0f);
+    });
+
+    passed &= checkStateRoundTrip (prefix + "state round trip", processor);
+    setParameter (processor, "BYPASS", 0.0f);
+
+    // A new prepareToPlay at another rate while the old state is in use.
+    passed &= runScenario (prefix + "re-prepare", processor, buffer, numBlocks, [&processor, blockSize] (int block)
+    {
+        if (block % 500 == 0)
+            processor.prepareToPlay (block % 1000 == 0 ? 96000.0 : 44100.0, blockSize);
+    });
+
+    processor.releaseResources();
+    processor.removeListener (&hostListener);
+    return passed;
+}
+
+//==============================================================================
+/** Stands in for a host's message thread: keeps re-preparing a chorus at
+    alternating rates and freeing the states it retires, as fast as it can.
+*/
+template <typename SampleType>
+class PrepareThread  : public Thread
+{
+public:
+    PrepareThread (ChorusProcessor<SampleType>& c, int channels, int blockSize)
+        : Thread ("EZ Chorus RTCheck prepare"), chorus (c), numChannels (channels), maxBlockSize (blockSize)
+    {
+    }
+
+    void run() override
+    {
+        const double rates[] = { 44100.0, 96000.0, 48000.0, 192000.0 };
+
+        for (int i = 0; ! threadShouldExit(); ++i)
+        {
+            chorus.prepare ({ rates[i % numElementsInArray (rates)], (uint32) maxBlockSize, (uint32) numChannels });
+            chorus.collectGarbage();
+            Thread::sleep (1);
+        }
+    }
+
+private:
+    ChorusProcessor<SampleType>& chorus;
+    const int numChannels;
+    const int maxBlockSize;
+};
+
+/** Processes blocks through a ChorusProcessor while another thread keeps
+    re-preparing it. Only the processing thread is audited.
+*/
+template <typename SampleType>
+static bool runConcurrentPrepare (int numChannels, int blockSize, int numBlocks)
+{
+    constexpr auto isDouble = std::is_same_v<SampleType, double>;
+
+    // The settings stay fixed while the other thread runs, since prepare()
+    // reads their oversampling factor.
+    ChorusSettings settings;
+    settings.mix = 0.5f;
+    settings.feedback = 0.5f;
+    settings.numVoices = 4;
+    settings.oversamplingFactor = 2;
+
+    ChorusProcessor<SampleType> chorus;
+    chorus.setSettings (settings);
+    chorus.prepare ({ 48000.0, (uint32) blockSize, (uint32) numChannels });
+
+    AudioBuffer<SampleType> buffer (numChannels, blockSize);
+    dsp::AudioBlock<SampleType> block (buffer);
+    Random random (0x5eed);
+    const auto before = RealtimeAudit::total();
+
+    {
+        PrepareThread<SampleType> preparer (chorus, numChannels, blockSize);
+        preparer.startThread();
+
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample (ch, i, (SampleType) ((random.nextFloat() * 2.0f - 1.0f) * 0.25f));
+
+            RealtimeAudit::ScopedAudit audit;
+            chorus.process (dsp::ProcessContextReplacing<SampleType> (block));
+        }
+
+        preparer.stopThread (1000);
+    }
+
+    const auto name = String (isDouble ? "double, " : "float, ") + String (numChannels) + " ch, " + String (blockSize)
+                    + " samples: re-prepare from another thread";
+    return report (name, RealtimeAudit::total() - before);
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    int numBlocks = 2000;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const String arg (argv[i]);
+
+        if (arg == "--blocks" && i + 1 < argc)
+            numBlocks = jmax (1, String (argv[++i]).getIntValue());
+        else if (arg == "--abort")
+            RealtimeAudit::abortOnViolation = true;
+        else
+        {
+            std::cout << "Usage: EZChorusRTCheck [--blocks n] [--abort]" << std::endl;
+            return 1;
+        }
+    }
+
+    bool passed = true;
+    HostListener hostListener;
+
+    for (auto numChannels : { 1, 2, 6 })
+    {
+        for (auto blockSize : { 32, 256, 1024 })
+        {
+            passed &= runProcessor<float> (numChannels, blockSize, numBlocks, hostListener);
+            passed &= runProcessor<double> (numChannels, blockSize, numBlocks, hostListener);
+            passed &= runConcurrentPrepare<float> (numChannels, blockSize, numBlocks);
+            passed &= runConcurrentPrepare<double> (numChannels, blockSize, numBlocks);
+        }
+    }
+
+    std::cout << std::endl
+              << "Allocations: " << RealtimeAudit::violations[RealtimeAudit::allocation].load()
+              << ", deallocations: " << RealtimeAudit::violations[RealtimeAudit::deallocation].load()
+              << ", blocking calls: " << RealtimeAudit::violations[RealtimeAudit::blockingCall].load() << std::endl;
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,290 @@
+/*
+  ==============================================================================
+
+    Headless offline renderer for EZ Chorus.
+
+    Streams WAV/AIFF files through EZChorusAudioProcessor in fixed-size
+    blocks, one processor instance per worker thread.
+
+    Usage:
+        EZChorusRender [options] <input files...>
+
+        --out <dir>          output directory (required)
+        --state <file>       state blob saved by getStateInformation()
+        --param <ID=value>   override a parameter, e.g. --param MIX=0.3
+        --block <samples>    block size (default 512)
+        --threads <n>        worker count (default: number of CPU cores)
+        --stats <file>       write each file's processBlock timings as JSON
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+using namespace juce;
+
+//==============================================================================
+struct RenderSettings
+{
+    File outputDir;
+    MemoryBlock state;
+    StringPairArray parameterOverrides;
+    int blockSize = 512;
+    int numThreads = SystemStats::getNumCpus();
+    File statsFile;
+};
+
+struct RenderJob
+{
+    File input;
+    File output;
+    double secondsRendered = 0;
+    bool succeeded = false;
+    String error;
+    var processorStats;
+};
+
+//==============================================================================
+class RenderWorker  : public Thread
+{
+public:
+    RenderWorker (const RenderSettings& s, OwnedArray<RenderJob>& j, std::atomic<int>& next)
+        : Thread ("EZ Chorus render worker"), settings (s), jobs (j), nextJob (next)
+    {
+        formatManager.registerBasicFormats();
+    }
+
+    ~RenderWorker() override
+    {
+        stopThread (-1);
+    }
+
+    void run() override
+    {
+        for (;;)
+        {
+            auto index = nextJob.fetch_add (1);
+            if (index >= jobs.size() || threadShouldExit())
+                break;
+
+            render (*jobs.getUnchecked (index));
+        }
+    }
+
+private:
+    void applySettings()
+    {
+        if (settings.state.getSize() > 0)
+            processor.setStateInformation (settings.state.getData(), (int) settings.state.getSize());
+
+        for (auto& id : settings.parameterOverrides.getAllKeys())
+        {
+            if (auto* param = processor.apvts.getParameter (id))
+                param->setValueNotifyingHost (param->convertTo0to1 (settings.parameterOverrides[id].getFloatValue()));
+        }
+    }
+
+    void render (RenderJob& job)
+    {
+        std::unique_ptr<AudioFormatReader> reader (formatManager.createReaderFor (job.input));
+        if (reader == nullptr)
+        {
+            job.error = "could not open " + job.input.getFullPathName();
+            return;
+        }
+
+        // Checked before the output is touched, so a rejected file leaves any
+        // earlier render of it in place.
+        const auto fileChannels = (int) reader->numChannels;
+        if (fileChannels > ChorusStateBase::maxChannels)
+        {
+            job.error = job.input.getFileName() + " has more channels than the processor supports";
+            return;
+        }
+
+        auto* format = formatManager.findFormatForFileExtension (job.output.getFileExtension());
+        if (format == nullptr)
+        {
+            job.error = "no writer for " + job.output.getFileName();
+            return;
+        }
+
+        job.output.deleteFile();
+        std::unique_ptr<OutputStream> stream (job.output.createOutputStream());
+        if (stream == nullptr)
+        {
+            job.error = "could not create " + job.output.getFullPathName();
+            return;
+        }
+
+        const auto sampleRate = reader->sampleRate;
+        std::unique_ptr<AudioFormatWriter> writer (format->createWriterFor (stream.get(), sampleRate, (unsigned int) fileChannels,
+                                                                            (int) reader->bitsPerSample, {}, 0));
+        if (writer == nullptr)
+        {
+            job.error = "could not create writer for " + job.output.getFullPathName();
+            return;
+        }
+        stream.release();
+
+        // Rendering is offline, so wide beds can use the channel worker pool.
+        processor.setNonRealtime (true);
+        processor.setPlayConfigDetails (fileChannels, fileChannels, sampleRate, settings.blockSize);
+        applySettings();
+        processor.prepareToPlay (sampleRate, settings.blockSize);
+
+        if (auto* stats = processor.getPerfStats())
+            stats->reset();
+
+        AudioBuffer<float> buffer (fileChannels, settings.blockSize);
+        MidiBuffer midi;
+
+        // Oversampling delays the output; render that much longer and drop
+        // the start so the file lines up with its input.
+        const auto latencySamples = (int64) processor.getLatencySamples();
+        const auto tailSamples = (int64) (processor.getTailLengthSeconds() * sampleRate);
+        const auto totalSamples = reader->lengthInSamples + tailSamples + latencySamples;
+
+        for (int64 position = 0; position < totalSamples; position += settings.blockSize)
+        {
+            const auto numSamples = (int) jmin ((int64) settings.blockSize, totalSamples - position);
+            buffer.setSize (buffer.getNumChannels(), numSamples, false, false, true);
+            buffer.clear();
+
+            if (position < reader->lengthInSamples)
+                reader->read (&buffer, 0, numSamples, position, true, true);
+
+            processor.processBlock (buffer, midi);
+
+            const auto skip = (int) jlimit ((int64) 0, (int64) numSamples, latencySamples - position);
+            writer->writeFromAudioSampleBuffer (buffer, skip, numSamples - skip);
+        }
+
+        if (auto* stats = processor.getPerfStats())
+            job.processorStats = stats->toVar();
+
+        processor.releaseResources();
+        job.secondsRendered = (double) (totalSamples - latencySamples) / sampleRate;
+        job.succeeded = true;
+    }
+
+    const RenderSettings& settings;
+    OwnedArray<RenderJob>& jobs;
+    std::atomic<int>& nextJob;
+    AudioFormatManager formatManager;
+    EZChorusAudioProcessor processor;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderWorker)
+};
+
+//==============================================================================
+static void printUsage()
+{
+    std::cout << "Usage: EZChorusRender --out <dir> [--state <file>] [--param ID=value]..." << std::endl
+              << "                      [--block <samples>] [--threads <n>] [--stats <file>] <input files...>" << std::endl;
+}
+
+int main (int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    RenderSettings settings;
+    Array<File> inputs;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const String arg (argv[i]);
+        const auto hasValue = i + 1 < argc;
+
+        if (arg == "--out" && hasValue)
+            settings.outputDir = File::getCurrentWorkingDirectory().getChildFile (argv[++i]);
+        else if (arg == "--state" && hasValue)
+            File::getCurrentWorkingDirectory().getChildFile (argv[++i]).loadFileAsData (settings.state);
+        else if (arg == "--param" && hasValue)
+        {
+            const String assignment (argv[++i]);
+            settings.parameterOverrides.set (assignment.upToFirstOccurrenceOf ("=", false, false),
+                                             assignment.fromFirstOccurrenceOf ("=", false, false));
+        }
+        else if (arg == "--block" && hasValue)
+            settings.blockSize = jmax (1, String (argv[++i]).getIntValue());
+        else if (arg == "--threads" && hasValue)
+            settings.numThreads = jmax (1, String (argv[++i]).getIntValue());
+        else if (arg == "--stats" && hasValue)
+            settings.statsFile = File::getCurrentWorkingDirectory().getChildFile (argv[++i]);
+        else if (arg.startsWith ("--"))
+        {
+            printUsage();
+            return 1;
+        }
+        else
+            inputs.add (File::getCurrentWorkingDirectory().getChildFile (arg));
+    }
+
+    if (inputs.isEmpty() || settings.outputDir == File())
+    {
+        printUsage();
+        return 1;
+    }
+
+    settings.outputDir.createDirectory();
+
+    OwnedArray<RenderJob> jobs;
+    for (auto& input : inputs)
+    {
+        auto* job = jobs.add (new RenderJob());
+        job->input = input;
+        job->output = settings.outputDir.getChildFile (input.getFileName());
+    }
+
+    std::atomic<int> nextJob { 0 };
+    OwnedArray<RenderWorker> workers;
+    for (int i = 0; i < jmin (settings.numThreads, jobs.size()); ++i)
+        workers.add (new RenderWorker (settings, jobs, nextJob));
+
+    const auto startTime = Time::getMillisecondCounterHiRes();
+
+    for (auto* worker : workers)
+        worker->startThread();
+
+    for (auto* worker : workers)
+        worker->waitForThreadToExit (-1);
+
+    const auto wallSeconds = (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+    int numRendered = 0;
+    double audioSeconds = 0;
+    for (auto* job : jobs)
+    {
+        if (job->succeeded)
+        {
+            ++numRendered;
+            audioSeconds += job->secondsRendered;
+        }
+        else
+            std::cerr << "Failed: " << job->error << std::endl;
+    }
+
+    std::cout << "Rendered " << numRendered << " of " << jobs.size() << " files ("
+              << String (audioSeconds, 1) << " s of audio) in " << String (wallSeconds, 2) << " s on "
+              << workers.size() << " threads" << std::endl
+              << "Throughput: " << String (numRendered * 3600.0 / jmax (wallSeconds, 1.0e-6), 1) << " files/hour, "
+              << String (audioSeconds / jmax (wallSeconds, 1.0e-6), 1) << "x realtime" << std::endl;
+
+    if (settings.statsFile != File())
+    {
+        Array<var> perFile;
+        for (auto* job : jobs)
+        {
+            auto* entry = new DynamicObject();
+            entry->setProperty ("file", job->input.getFullPathName());
+            entry->setProperty ("processorStats", job->processorStats);
+            perFile.add (var (entry));
+        }
+
+        settings.statsFile.replaceWithText (JSON::toString (var (perFile)));
+    }
+
+    return numRendered == jobs.size() ? 0 : 1;
+}
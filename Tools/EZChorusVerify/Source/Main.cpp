@@ -0,0 +1,817 @@
+/*
+  ==============================================================================
+
+    Golden-output check for EZ Chorus.
+
+    Renders deterministic signals (an impulse, a sine sweep, noise and
+    silence) through EZChorusAudioProcessor at several sample rates, host
+    block patterns and parameter sets. --record stores every render as a
+    reference WAV file; --compare renders them all again and checks each
+    against its reference, exiting with a non-zero status if any differs
+    by more than the tolerance, so a change to the DSP can be gated on it.
+
+    --ab renders every case with two kernel variants instead, checks the
+    second against the first and reports how their speeds compare. The
+    variants are:
+
+        float       EZChorusAudioProcessor, single precision
+        double      EZChorusAudioProcessor, double precision
+        dsp         ChorusProcessor<float> on its own, without the plugin
+        compact     ChorusProcessor<float> with half-float delay lines
+        reference   ReferenceChorus, a plain per-sample model written
+                    independently of the kernel
+
+    --ab reference,float checks the kernel against the model, so a build
+    can be verified without references recorded from an earlier one.
+    A new kernel is compared with the current one by adding it to
+    renderVariant() under a new name.
+
+    --steps reads a slow sine sweep through a delay line whose delay swings
+    slowly, with each interpolation quality, and fails if the allpass
+    output steps further from the exact signal between two samples than
+    linear interpolation does.
+
+    Usage:
+        EZChorusVerify (--record dir | --compare dir | --ab a,b | --steps)
+                       [--variant name] [--tolerance dB] [--seconds s]
+                       [--repeat n] [--out results.json]
+
+        --record    render with --variant (default float) into dir
+        --compare   render with --variant and check it against dir
+        --tolerance the largest difference allowed, in dB: both the peak
+                    error relative to full scale and the null-test residual
+                    relative to the reference's level must stay below it
+                    (default -90). Some comparisons allow more; see
+                    getTolerance().
+        --repeat    --ab times each render this many times and keeps the
+                    fastest (default 3)
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+using namespace juce;
+
+//==============================================================================
+struct ParameterSet
+{
+    const char* name;
+    float feedback, phaseOffset, mix, depth, rate;
+    int voices;
+    int quality;
+    int oversampling;
+    int economy;
+};
+
+// Between them these reach every interpolation quality, the multi-voice
+// layout, the feedback path and both resampling modes.
+static const ParameterSet parameterSets[] =
+{
+    { "default",               0.35f, 0.2f, 0.5f, 0.35f, 0.2f, 1, 0, 1, 1 },
+    { "high-feedback",         0.98f, 0.2f, 0.5f, 0.35f, 0.2f, 1, 0, 1, 1 },
+    { "deep-fast-hermite",     0.5f,  0.5f, 0.5f, 1.0f,  5.0f, 1, 1, 1, 1 },
+    { "eight-voices-lagrange", 0.35f, 0.2f, 0.5f, 0.35f, 0.2f, 8, 2, 1, 1 },
+    { "wide-allpass",          0.35f, 1.0f, 1.0f, 0.6f,  1.0f, 4, 3, 1, 1 },
+    { "oversampled-2x",        0.35f, 0.2f, 0.5f, 0.35f, 0.2f, 1, 0, 2, 1 },
+    { "economy-half",          0.35f, 0.2f, 0.5f, 0.35f, 0.2f, 1, 0, 1, 2 },
+};
+
+static const double sampleRates[] = { 44100.0, 96000.0 };
+
+static constexpr int numChannels = 2;
+static constexpr int maxBlockSize = 512;
+
+struct BlockPattern
+{
+    const char* name;
+    int sizes[8];
+    int numSizes;
+};
+
+static const BlockPattern blockPatterns[] =
+{
+    { "64",        { 64 },  1 },
+    { "512",       { 512 }, 1 },
+
+    // Uneven blocks of the kind hosts send around loop points and
+    // automation, down to a single sample and never above the prepared size.
+    { "irregular", { 512, 37, 1, 256, 300, 13, 480, 129 }, 8 },
+};
+
+static const StringArray signalNames { "impulse", "sweep", "noise", "silence" };
+static const StringArray variantNames { "float", "double", "dsp", "compact", "reference" };
+
+struct Case
+{
+    String signal;
+    const ParameterSet* set;
+    double sampleRate;
+    const BlockPattern* pattern;
+
+    String getName() const
+    {
+        return signal + "_" + set->name + "_" + String (roundToInt (sampleRate)) + "_" + pattern->name;
+    }
+};
+
+//==============================================================================
+static void setParameter (EZChorusAudioProcessor& processor, const String& id, float value)
+{
+    if (auto* param = processor.apvts.getParameter (id))
+        param->setValueNotifyingHost (param->convertTo0to1 (value));
+}
+
+static void applyParameterSet (EZChorusAudioProcessor& processor, const ParameterSet& set)
+{
+    setParameter (processor, "FEEDBACK", set.feedback);
+    setParameter (processor, "PHASEOFFSET", set.phaseOffset);
+    setParameter (processor, "MIX", set.mix);
+    setParameter (processor, "CHORUSDEPTH", set.depth);
+    setParameter (processor, "CHORUSRATE", set.rate);
+    setParameter (processor, "VOICES", (float) (set.voices - 1));
+    setParameter (processor, "QUALITY", (float) set.quality);
+    setParameter (processor, "OVERSAMPLING", std::log2 ((float) set.oversampling));
+    setParameter (processor, "ECONOMY", std::log2 ((float) set.economy));
+}
+
+/** The same input for every run: a full-scale impulse, an exponential sine
+    sweep from 20 Hz to 20 kHz (or 0.45 of the rate), fixed-seed noise, or
+    silence, on every channel.
+*/
+static AudioBuffer<float> makeSignal (const String& signal, double sampleRate, int numSamples)
+{
+    AudioBuffer<float> buffer (numChannels, numSamples);
+    buffer.clear();
+
+    if (signal == "impulse")
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            buffer.setSample (ch, 0, 1.0f);
+    }
+    else if (signal == "sweep")
+    {
+        const auto startHz = 20.0;
+        const auto endHz = jmin (20000.0, 0.45 * sampleRate);
+        const auto duration = numSamples / sampleRate;
+        const auto logRatio = std::log (endHz / startHz);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto t = i / sampleRate;
+            const auto phase = MathConstants<double>::twoPi * startHz * duration / logRatio
+                                 * (std::exp (t / duration * logRatio) - 1.0);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                buffer.setSample (ch, i, (float) (0.5 * std::sin (phase)));
+        }
+    }
+    else if (signal == "noise")
+    {
+        Random random (0x5eed);
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                buffer.setSample (ch, i, (random.nextFloat() * 2.0f - 1.0f) * 0.25f);
+    }
+
+    return buffer;
+}
+
+//==============================================================================
+/**
+    A plain model of the chorus, written from its description rather than
+    from the kernel: double precision throughout, std::sin for the LFO, one
+    sample and one voice at a time, and no chunks, tables, lanes or vector
+    operations.
+
+    Each channel writes input + feedback * its previous wet sample into its
+    delay line. Its wet sample is the weighted sum of its voices, each read
+    centre + swing * depth * lfo samples back, and the output is
+    input + mix * (wet - input). Each quality uses the scalar formula from
+    DelayInterpolation, which defines it. It runs at the kernel rate, so
+    oversampling wraps it in JUCE's filters; economy mode isn't modelled.
+*/
+class ReferenceChorus
+{
+public:
+    ReferenceChorus (const ChorusSettings& s, double kernelRate, int channels)
+        : settings (s), rate (kernelRate), numChannels (channels),
+          lineLength (nextPowerOfTwo ((int) (kernelRate * maxDelaySeconds) + 8))
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            lines.emplace_back ((size_t) lineLength, 0.0);
+
+        // Voices are spread from -1 to +1: their rates fan out by up to
+        // +/-25%, and for stereo each one is panned by its position. Each
+        // channel's gains add up to one.
+        for (int v = 0; v < settings.numVoices; ++v)
+        {
+            const auto position = settings.numVoices > 1 ? 2.0 * v / (settings.numVoices - 1) - 1.0 : 0.0;
+            const auto pan = settings.voiceSpread * position;
+            voiceRates[v] = 1.0 + 0.25 * settings.voiceSpread * position;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                gains[ch][v] = numChannels != 2 ? 1.0 : (ch == 0 ? 1.0 - jmax (0.0, pan) : 1.0 + jmin (0.0, pan));
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            double total = 0;
+            for (int v = 0; v < settings.numVoices; ++v)
+                total += gains[ch][v];
+
+            for (int v = 0; v < settings.numVoices; ++v)
+                gains[ch][v] /= total;
+
+            // The channels' LFO taps are spread round the cycle by the phase offset.
+            const auto offset = numChannels > 1 ? settings.phaseOffset * 2.0 * ch / numChannels : 0.0;
+            channelOffsets[ch] = offset - std::floor (offset);
+        }
+    }
+
+    void process (const dsp::AudioBlock<double>& block)
+    {
+        for (size_t i = 0; i < block.getNumSamples(); ++i, ++time)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto& line = lines[(size_t) ch];
+                auto* channel = block.getChannelPointer ((size_t) ch);
+                const auto input = channel[i];
+                double wet = 0;
+
+                for (int v = 0; v < settings.numVoices; ++v)
+                {
+                    auto phase = (double) v / settings.numVoices + channelOffsets[ch]
+                                   + (double) time * settings.rate * voiceRates[v] / rate;
+                    phase -= std::floor (phase);
+
+                    const auto lfo = std::sin (MathConstants<double>::twoPi * phase);
+                    const auto delay = rate * (0.5 * (minDelaySeconds + maxDelaySeconds)
+                                                 + 0.5 * (maxDelaySeconds - minDelaySeconds) * settings.depth * lfo);
+                    const auto position = (double) time - delay;
+                    const auto index = (int64) std::floor (position);
+
+                    // x[-1]..x[2] around the read position; nothing before
+                    // the first sample has been written.
+                    double p[4];
+                    for (int k = 0; k < 4; ++k)
+                        p[k] = index - 1 + k >= 0 ? line[(size_t) ((index - 1 + k) & (lineLength - 1))] : 0.0;
+
+                    wet += gains[ch][v] * interpolate (p, position - (double) index, allpassState[ch][v]);
+                }
+
+                line[(size_t) (time & (lineLength - 1))] = input + settings.feedback * lastWet[ch];
+                lastWet[ch] = wet;
+                channel[i] = input + settings.mix * (wet - input);
+            }
+        }
+    }
+
+private:
+    static constexpr double minDelaySeconds = 0.005, maxDelaySeconds = 0.03;
+    static constexpr int maxVoices = ChorusLFO::maxVoices, maxChannels = ChorusStateBase::maxChannels;
+
+    double interpolate (const double* p, double frac, DelayInterpolation::State<double>& state) const
+    {
+        switch (settings.quality)
+        {
+            case DelayInterpolation::Quality::hermite:   return DelayInterpolation::Hermite::interpolate (p, frac, state);
+            case DelayInterpolation::Quality::lagrange:  return DelayInterpolation::Lagrange::interpolate (p, frac, state);
+            case DelayInterpolation::Quality::allpass:   return DelayInterpolation::Allpass::interpolate (p, frac, state);
+            case DelayInterpolation::Quality::linear:
+            default:                                     return DelayInterpolation::Linear::interpolate (p, frac, state);
+        }
+    }
+
+    const ChorusSettings settings;
+    const double rate;
+    const int numChannels, lineLength;
+    std::vector<std::vector<double>> lines;
+    double voiceRates[maxVoices] = {};
+    double gains[maxChannels][maxVoices] = {};
+    double channelOffsets[maxChannels] = {};
+    DelayInterpolation::State<double> allpassState[maxChannels][maxVoices] = {};
+    double lastWet[maxChannels] = {};
+    int64 time = 0;
+};
+
+//==============================================================================
+/** Calls processBlock with successive slices of audio, sized by the
+    pattern, and returns the seconds spent in it.
+*/
+template <typename SampleType, typename ProcessFunction>
+static double processInBlocks (const BlockPattern& pattern, AudioBuffer<SampleType>& audio, ProcessFunction&& processBlock)
+{
+    int64 ticks = 0;
+
+    for (int start = 0, next = 0; start < audio.getNumSamples(); ++next)
+    {
+        const auto numSamples = jmin (pattern.sizes[next % pattern.numSizes], audio.getNumSamples() - start);
+        AudioBuffer<SampleType> block (audio.getArrayOfWritePointers(), numChannels, start, numSamples);
+
+        const auto blockStart = Time::getHighResolutionTicks();
+        processBlock (block);
+        ticks += Time::getHighResolutionTicks() - blockStart;
+
+        start += numSamples;
+    }
+
+    return Time::highResolutionTicksToSeconds (ticks);
+}
+
+/** Renders audio in place through the named variant, and returns the
+    seconds spent processing it.
+*/
+static double renderVariant (const String& variant, const Case& c, AudioBuffer<float>& audio)
+{
+    EZChorusAudioProcessor processor;
+    processor.setPlayConfigDetails (numChannels, numChannels, c.sampleRate, maxBlockSize);
+    applyParameterSet (processor, *c.set);
+    MidiBuffer midi;
+
+    if (variant == "float")
+    {
+        processor.prepareToPlay (c.sampleRate, maxBlockSize);
+        return processInBlocks (*c.pattern, audio, [&] (AudioBuffer<float>& block) { processor.processBlock (block, midi); });
+    }
+
+    if (variant == "double")
+    {
+        // Converted outside the timed region, as a double-precision host's
+        // buffers would already be.
+        processor.setProcessingPrecision (AudioProcessor::doublePrecision);
+        processor.prepareToPlay (c.sampleRate, maxBlockSize);
+
+        AudioBuffer<double> doubleAudio;
+        doubleAudio.makeCopyOf (audio);
+        const auto seconds = processInBlocks (*c.pattern, doubleAudio, [&] (AudioBuffer<double>& block) { processor.processBlock (block, midi); });
+        audio.makeCopyOf (doubleAudio);
+        return seconds;
+    }
+
+    // The settings exactly as the plugin sees them after the parameter
+    // ranges have snapped them.
+    const auto settings = ChorusParameterSnapshot (processor.apvts).get();
+
+    if (variant == "reference")
+    {
+        ReferenceChorus chorus (settings, c.sampleRate * settings.oversamplingFactor, numChannels);
+        std::unique_ptr<dsp::Oversampling<double>> oversampler;
+
+        if (settings.oversamplingFactor > 1)
+        {
+            oversampler = std::make_unique<dsp::Oversampling<double>> ((size_t) numChannels, (size_t) roundToInt (std::log2 (settings.oversamplingFactor)),
+                                                                       dsp::Oversampling<double>::filterHalfBandPolyphaseIIR, false, true);
+            oversampler->initProcessing ((size_t) maxBlockSize);
+        }
+
+        AudioBuffer<double> doubleAudio;
+        doubleAudio.makeCopyOf (audio);
+
+        const auto seconds = processInBlocks (*c.pattern, doubleAudio, [&] (AudioBuffer<double>& block)
+        {
+            dsp::AudioBlock<double> hostBlock (block);
+
+            if (oversampler == nullptr)
+            {
+                chorus.process (hostBlock);
+                return;
+            }
+
+            chorus.process (oversampler->processSamplesUp (hostBlock));
+            oversampler->processSamplesDown (hostBlock);
+        });
+
+        audio.makeCopyOf (doubleAudio);
+        return seconds;
+    }
+
+    ChorusProcessor<float> chorus;
+    chorus.setDelayStorage (variant == "compact" ? DelayStorage::half : DelayStorage::full);
+
+    // The settings go in first so the state is built for their
+    // oversampling factor.
+    chorus.setSettings (settings);
+    chorus.prepare ({ c.sampleRate, (uint32) maxBlockSize, (uint32) numChannels });
+    chorus.reset();
+
+    return processInBlocks (*c.pattern, audio, [&] (AudioBuffer<float>& block)
+    {
+        dsp::AudioBlock<float> audioBlock (block);
+        chorus.process (dsp::ProcessContextReplacing<float> (audioBlock));
+    });
+}
+
+/** False for cases a variant doesn't model. */
+static bool canRender (const String& variant, const Case& c)
+{
+    return variant != "reference" || c.set->economy == 1 || c.set->oversampling > 1;
+}
+
+//==============================================================================
+struct Difference
+{
+    float maxError = 0;     // peak absolute difference
+    double nullDb = -200;   // residual level relative to the reference's, or to full scale if it is silent
+    bool lengthsMatch = true;
+
+    double getMaxErrorDb() const    { return Decibels::gainToDecibels ((double) maxError, -200.0); }
+};
+
+struct Tolerance
+{
+    double maxErrorDb, nullDb;
+
+    bool passes (const Difference& difference) const
+    {
+        return difference.lengthsMatch && difference.getMaxErrorDb() <= maxErrorDb && difference.nullDb <= nullDb;
+    }
+
+    Tolerance atLeast (Tolerance other) const
+    {
+        return { jmax (maxErrorDb, other.maxErrorDb), jmax (nullDb, other.nullDb) };
+    }
+};
+
+/** The limits for comparing a render by variant b against one by variant a
+    (the variant recorded, for --compare). requestedDb applies to both
+    metrics, but some comparisons can't meet a tight one:
+
+    - Half-float delay lines against full ones add quantisation noise, up to
+      ChorusStateBase::halfStorageNoiseDb. Measured with the kernel, the
+      worst case here is a -68 dB null and a -60 dBFS peak, at high feedback.
+    - The kernel against ReferenceChorus differs by its float read positions
+      and LFO table. The worst case measured is -59 dB, and the limit is -50
+      for every quality, the allpass included.
+*/
+static Tolerance getTolerance (const String& a, const String& b, double requestedDb)
+{
+    Tolerance tolerance { requestedDb, requestedDb };
+
+    if ((a == "compact") != (b == "compact"))
+        tolerance = tolerance.atLeast ({ ChorusStateBase::halfStorageNoiseDb, ChorusStateBase::halfStorageNoiseDb });
+
+    if ((a == "reference") != (b == "reference"))
+        tolerance = tolerance.atLeast ({ -50.0, -50.0 });
+
+    return tolerance;
+}
+
+static Difference compare (const AudioBuffer<float>& reference, const AudioBuffer<float>& output)
+{
+    Difference result;
+
+    if (reference.getNumChannels() != output.getNumChannels()
+         || reference.getNumSamples() != output.getNumSamples())
+    {
+        result.lengthsMatch = false;
+        return result;
+    }
+
+    double residualEnergy = 0, referenceEnergy = 0;
+
+    for (int ch = 0; ch < reference.getNumChannels(); ++ch)
+        for (int i = 0; i < reference.getNumSamples(); ++i)
+        {
+            const auto expected = reference.getSample (ch, i);
+            const auto difference = output.getSample (ch, i) - expected;
+            result.maxError = jmax (result.maxError, std::abs (difference));
+            residualEnergy += (double) difference * difference;
+            referenceEnergy += (double) expected * expected;
+        }
+
+    const auto numValues = (double) reference.getNumChannels() * reference.getNumSamples();
+    const auto referenceLevel = referenceEnergy > 0 ? referenceEnergy : numValues;
+    result.nullDb = Decibels::gainToDecibels (std::sqrt (residualEnergy / referenceLevel), -200.0);
+    return result;
+}
+
+static bool writeReference (const File& file, const AudioBuffer<float>& audio, double sampleRate)
+{
+    file.deleteFile();
+    std::unique_ptr<OutputStream> stream (file.createOutputStream());
+
+    if (stream == nullptr)
+        return false;
+
+    WavAudioFormat wav;
+    std::unique_ptr<AudioFormatWriter> writer (wav.createWriterFor (stream.get(), sampleRate, (unsigned int) audio.getNumChannels(),
+                                                                    32, {}, 0));
+    if (writer == nullptr)
+        return false;
+
+    stream.release();   // now owned by the writer
+    return writer->writeFromAudioSampleBuffer (audio, 0, audio.getNumSamples());
+}
+
+static bool readReference (const File& file, AudioBuffer<float>& audio)
+{
+    if (! file.existsAsFile())
+        return false;
+
+    WavAudioFormat wav;
+    std::unique_ptr<AudioFormatReader> reader (wav.createReaderFor (file.createInputStream().release(), true));
+
+    if (reader == nullptr)
+        return false;
+
+    audio.setSize ((int) reader->numChannels, (int) reader->lengthInSamples);
+    return reader->read (&audio, 0, audio.getNumSamples(), 0, true, true);
+}
+
+//==============================================================================
+/** Reads a sine sweep from 20 Hz to 10 kHz through a ModulatedDelayLine
+    with Interpolator, one sample at a time, while the delay swings by
+    +/-2 ms at 0.5 Hz. Returns the largest change from one sample to the
+    next in the error against the exact delayed sine, in dB relative to
+    full scale. The error of a smooth interpolator changes gradually with
+    the signal; a click adds a jump.
+*/
+template <typename Interpolator>
+static double measureInterpolationSteps()
+{
+    constexpr double sampleRate = 48000.0, seconds = 10.0, startHz = 20.0, endHz = 10000.0;
+    constexpr double centreDelay = 0.005 * sampleRate, swing = 0.002 * sampleRate, swingHz = 0.5;
+    const auto numSamples = (int) (seconds * sampleRate);
+    const auto logRatio = std::log (endHz / startHz);
+
+    const auto sweep = [logRatio] (double time)
+    {
+        if (time < 0)
+            return 0.0;
+
+        return 0.5 * std::sin (MathConstants<double>::twoPi * startHz * seconds / logRatio
+                                 * (std::exp (time / seconds / sampleRate * logRatio) - 1.0));
+    };
+
+    ModulatedDelayLine<float> line;
+    line.prepare ((int) (centreDelay + swing) + 2);
+    DelayInterpolation::State<float> state;
+
+    double lastError = 0, largestStep = 0;
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        const auto delay = centreDelay + swing * std::sin (MathConstants<double>::twoPi * swingHz * n / sampleRate);
+        const auto readOrigin = line.getReadOrigin();
+        const auto position = readOrigin - (float) delay;
+
+        float output;
+        line.read<Interpolator> (&position, &output, 1, state);
+
+        const auto input = (float) sweep (n);
+        line.push (&input, 1);
+
+        // Against the position the line was actually asked for, after
+        // rounding to float.
+        const auto error = (double) output - sweep (n - ((double) readOrigin - (double) position));
+
+        // Skip the first second, while the sweep is still too low to tell
+        // the qualities apart.
+        if (n > (int) sampleRate)
+            largestStep = jmax (largestStep, std::abs (error - lastError));
+
+        lastError = error;
+    }
+
+    return Decibels::gainToDecibels (largestStep, -200.0);
+}
+
+/** Prints each quality's largest step and returns false if the allpass's
+    is larger than linear interpolation's.
+*/
+static bool checkInterpolationSteps()
+{
+    const double steps[] = { measureInterpolationSteps<DelayInterpolation::Linear>(),
+                             measureInterpolationSteps<DelayInterpolation::Hermite>(),
+                             measureInterpolationSteps<DelayInterpolation::Lagrange>(),
+                             measureInterpolationSteps<DelayInterpolation::Allpass>() };
+    const char* names[] = { "linear", "hermite", "lagrange", "allpass" };
+
+    for (int q = 0; q < numElementsInArray (steps); ++q)
+        std::cerr << names[q] << ": largest error step " << String (steps[q], 1) << " dBFS" << std::endl;
+
+    const auto passed = steps[3] <= steps[0];
+    std::cerr << (passed ? "ok    " : "FAIL  ") << "allpass steps no further than linear" << std::endl;
+    return passed;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: EZChorusVerify (--record dir | --compare dir | --ab a,b | --steps) [--variant name]"
+              << " [--tolerance dB] [--seconds s] [--repeat n] [--out results.json]" << std::endl
+              << "Variants: " << variantNames.joinIntoString (", ") << std::endl;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    File recordDirectory, compareDirectory, outputFile;
+    String variant = "float";
+    StringArray abVariants;
+    double toleranceDb = -90.0;
+    double secondsOfAudio = 0.25;
+    int repeats = 3;
+    bool checkSteps = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const String arg (argv[i]);
+        const auto hasValue = i + 1 < argc;
+
+        if (arg == "--record" && hasValue)
+            recordDirectory = File::getCurrentWorkingDirectory().getChildFile (argv[++i]);
+        else if (arg == "--compare" && hasValue)
+            compareDirectory = File::getCurrentWorkingDirectory().getChildFile (argv[++i]);
+        else if (arg == "--ab" && hasValue)
+            abVariants = StringArray::fromTokens (argv[++i], ",", {});
+        else if (arg == "--steps")
+            checkSteps = true;
+        else if (arg == "--variant" && hasValue && variantNames.contains (argv[i + 1]))
+            variant = argv[++i];
+        else if (arg == "--tolerance" && hasValue)
+            toleranceDb = String (argv[++i]).getDoubleValue();
+        else if (arg == "--seconds" && hasValue)
+            secondsOfAudio = jmax (0.01, String (argv[++i]).getDoubleValue());
+        else if (arg == "--repeat" && hasValue)
+            repeats = jmax (1, String (argv[++i]).getIntValue());
+        else if (arg == "--out" && hasValue)
+            outputFile = File::getCurrentWorkingDirectory().getChildFile (argv[++i]);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    const auto isRecording = recordDirectory != File();
+    const auto isAB = ! abVariants.isEmpty();
+    const auto numModes = (isRecording ? 1 : 0) + (compareDirectory != File() ? 1 : 0) + (isAB ? 1 : 0) + (checkSteps ? 1 : 0);
+
+    if (numModes != 1 || (isAB && (abVariants.size() != 2 || ! variantNames.contains (abVariants[0])
+                                                          || ! variantNames.contains (abVariants[1]))))
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (checkSteps)
+        return checkInterpolationSteps() ? 0 : 1;
+
+    if (isRecording && ! recordDirectory.createDirectory())
+    {
+        std::cerr << "Can't create " << recordDirectory.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    Array<Case> cases;
+    for (auto& signal : signalNames)
+        for (auto& set : parameterSets)
+            for (auto sampleRate : sampleRates)
+                for (auto& pattern : blockPatterns)
+                    cases.add (Case { signal, &set, sampleRate, &pattern });
+
+    Array<var> results;
+    int numFailures = 0, numSkipped = 0;
+    double totalSeconds[2] = {};
+
+    for (auto& c : cases)
+    {
+        const auto name = c.getName();
+
+        if (! canRender (variant, c) || (isAB && (! canRender (abVariants[0], c) || ! canRender (abVariants[1], c))))
+        {
+            ++numSkipped;
+            continue;
+        }
+
+        const auto input = makeSignal (c.signal, c.sampleRate, (int) (secondsOfAudio * c.sampleRate));
+
+        if (isRecording)
+        {
+            AudioBuffer<float> output;
+            output.makeCopyOf (input);
+            renderVariant (variant, c, output);
+
+            const auto file = recordDirectory.getChildFile (name + ".wav");
+            if (! writeReference (file, output, c.sampleRate))
+            {
+                std::cerr << "Can't write " << file.getFullPathName() << std::endl;
+                return 1;
+            }
+
+            continue;
+        }
+
+        auto* result = new DynamicObject();
+        result->setProperty ("case", name);
+
+        if (isAB)
+        {
+            AudioBuffer<float> outputs[2];
+            double seconds[2];
+
+            for (int v = 0; v < 2; ++v)
+            {
+                seconds[v] = std::numeric_limits<double>::max();
+
+                for (int r = 0; r < repeats; ++r)
+                {
+                    outputs[v].makeCopyOf (input);
+                    seconds[v] = jmin (seconds[v], renderVariant (abVariants[v], c, outputs[v]));
+                }
+
+                totalSeconds[v] += seconds[v];
+            }
+
+            const auto difference = compare (outputs[0], outputs[1]);
+            const auto passed = getTolerance (abVariants[0], abVariants[1], toleranceDb).passes (difference);
+
+            if (! passed)
+                ++numFailures;
+
+            result->setProperty ("passed", passed);
+            result->setProperty ("maxErrorDb", difference.getMaxErrorDb());
+            result->setProperty ("nullDb", difference.nullDb);
+            result->setProperty ("speedRatio", seconds[0] / jmax (seconds[1], 1.0e-9));
+
+            std::cerr << (passed ? "ok    " : "FAIL  ") << name << ": max error " << String (difference.getMaxErrorDb(), 1)
+                      << " dB, null " << String (difference.nullDb, 1) << " dB, " << abVariants[1] << " "
+                      << String (seconds[0] / jmax (seconds[1], 1.0e-9), 2) << "x the speed of " << abVariants[0] << std::endl;
+        }
+        else
+        {
+            AudioBuffer<float> output;
+            output.makeCopyOf (input);
+            renderVariant (variant, c, output);
+
+            AudioBuffer<float> reference;
+            const auto found = readReference (compareDirectory.getChildFile (name + ".wav"), reference);
+            const auto difference = found ? compare (reference, output) : Difference();
+            const auto passed = found && getTolerance (variant, variant, toleranceDb).passes (difference);
+
+            if (! passed)
+                ++numFailures;
+
+            result->setProperty ("passed", passed);
+            result->setProperty ("maxErrorDb", difference.getMaxErrorDb());
+            result->setProperty ("nullDb", difference.nullDb);
+
+            std::cerr << (passed ? "ok    " : "FAIL  ") << name << ": ";
+
+            if (! found)
+                std::cerr << "no reference" << std::endl;
+            else if (! difference.lengthsMatch)
+                std::cerr << "length or channel count differs" << std::endl;
+            else
+                std::cerr << "max error " << String (difference.getMaxErrorDb(), 1) << " dB, null "
+                          << String (difference.nullDb, 1) << " dB" << std::endl;
+        }
+
+        results.add (var (result));
+    }
+
+    if (isRecording)
+    {
+        std::cerr << "Recorded " << (cases.size() - numSkipped) << " references with " << variant << " in "
+                  << recordDirectory.getFullPathName() << std::endl;
+        return 0;
+    }
+
+    auto* run = new DynamicObject();
+    run->setProperty ("date", Time::getCurrentTime().toISO8601 (true));
+    run->setProperty ("cpu", SystemStats::getCpuModel());
+    run->setProperty ("results", results);
+    run->setProperty ("toleranceDb", toleranceDb);
+    run->setProperty ("failures", numFailures);
+    run->setProperty ("skipped", numSkipped);
+
+    const auto numChecked = cases.size() - numSkipped;
+
+    if (isAB)
+    {
+        const auto speedRatio = totalSeconds[0] / jmax (totalSeconds[1], 1.0e-9);
+        run->setProperty ("variants", abVariants.joinIntoString (","));
+        run->setProperty ("speedRatio", speedRatio);
+        std::cerr << (numChecked - numFailures) << " of " << numChecked << " cases match " << abVariants[0] << std::endl
+                  << "Overall " << abVariants[1] << " runs at " << String (speedRatio, 2) << "x the speed of "
+                  << abVariants[0] << std::endl;
+    }
+    else
+    {
+        run->setProperty ("variant", variant);
+        std::cerr << (numChecked - numFailures) << " of " << numChecked << " cases match the references" << std::endl;
+    }
+
+    if (numSkipped > 0)
+        std::cerr << numSkipped << " cases skipped: the reference model doesn't cover economy mode" << std::endl;
+
+    if (outputFile != File())
+        outputFile.replaceWithText (JSON::toString (var (run)));
+
+    return numFailures > 0 ? 1 : 0;
+}